@@ -0,0 +1,116 @@
+#include "AllocationTracker.h"
+#include <cstdlib>
+#include <new>
+
+//Plain data, so the counters need no constructor and work from the first allocation of a thread
+static thread_local AllocationCounts threadCounts;
+
+bool AllocationTracker::isEnabled()
+{
+#ifdef TRACK_ALLOCATIONS
+	return true;
+#else
+	return false;
+#endif
+}
+
+AllocationCounts AllocationTracker::getThreadCounts()
+{
+	return threadCounts;
+}
+
+void AllocationTracker::countAllocation(size_t bytes)
+{
+	threadCounts.allocations += 1;
+	threadCounts.bytes += (long long)bytes;
+}
+
+void AllocationTracker::countFree()
+{
+	threadCounts.frees += 1;
+}
+
+void AllocationTracker::countTexture()
+{
+	threadCounts.textures += 1;
+}
+
+void AllocationTracker::countSurface()
+{
+	threadCounts.surfaces += 1;
+}
+
+AllocationCounts operator-(const AllocationCounts& later, const AllocationCounts& earlier)
+{
+	AllocationCounts difference;
+	difference.allocations = later.allocations - earlier.allocations;
+	difference.bytes = later.bytes - earlier.bytes;
+	difference.frees = later.frees - earlier.frees;
+	difference.textures = later.textures - earlier.textures;
+	difference.surfaces = later.surfaces - earlier.surfaces;
+	return difference;
+}
+
+#ifdef TRACK_ALLOCATIONS
+//Replacements of the global allocation functions, the array, sized and nothrow forms all end up here
+void* operator new(size_t size)
+{
+	AllocationTracker::countAllocation(size);
+	void* memory = std::malloc(size == 0 ? 1 : size);
+	if (memory == NULL)
+	{
+		throw std::bad_alloc();
+	}
+	return memory;
+}
+
+void* operator new[](size_t size)
+{
+	return operator new(size);
+}
+
+void* operator new(size_t size, const std::nothrow_t&) noexcept
+{
+	AllocationTracker::countAllocation(size);
+	return std::malloc(size == 0 ? 1 : size);
+}
+
+void* operator new[](size_t size, const std::nothrow_t& tag) noexcept
+{
+	return operator new(size, tag);
+}
+
+void operator delete(void* memory) noexcept
+{
+	if (memory != NULL)
+	{
+		AllocationTracker::countFree();
+		std::free(memory);
+	}
+}
+
+void operator delete[](void* memory) noexcept
+{
+	operator delete(memory);
+}
+
+void operator delete(void* memory, size_t) noexcept
+{
+	operator delete(memory);
+}
+
+void operator delete[](void* memory, size_t) noexcept
+{
+	operator delete(memory);
+}
+
+void operator delete(void* memory, const std::nothrow_t&) noexcept
+{
+	operator delete(memory);
+}
+
+void operator delete[](void* memory, const std::nothrow_t&) noexcept
+{
+	operator delete(memory);
+}
+#endif
@@ -0,0 +1,40 @@
+#pragma once
+#include <cstddef>
+
+//Allocations made by one thread
+struct AllocationCounts
+{
+	//Heap allocations and the bytes they asked for
+	long long allocations;
+	long long bytes;
+	long long frees;
+
+	//GPU and CPU images created
+	int textures;
+	int surfaces;
+};
+
+//Counts the allocations of every thread into counters of its own
+//Heap counting is opt-in, build with TRACK_ALLOCATIONS to replace the global new and delete,
+//and call hookSdlAllocator in the game to count SDL_malloc and SDL_free as well
+//Texture and surface creations are counted by the code creating them, with or without the hooks
+class AllocationTracker
+{
+public:
+	//Checks whether the heap hooks are built in
+	static bool isEnabled();
+
+	//Gets the running totals of the calling thread, subtract two of them for a span
+	static AllocationCounts getThreadCounts();
+
+	//Counts an allocation or free on the calling thread
+	static void countAllocation(size_t bytes);
+	static void countFree();
+
+	//Counts a texture or surface the calling thread created, only once the creation succeeded
+	static void countTexture();
+	static void countSurface();
+};
+
+//Gets the allocations between two readings
+AllocationCounts operator-(const AllocationCounts& later, const AllocationCounts& earlier);
@@ -0,0 +1,173 @@
+#include "Arena.h"
+#include <stdio.h>
+#include <string.h>
+#include "GameObjects.h"
+
+//Longest line a layout file can have
+static const int MAX_LINE_LENGTH = 256;
+
+ArenaHandle Arena::getStandard()
+{
+	static ArenaHandle standard = [] {
+		std::shared_ptr<Arena> arena(new Arena());
+
+		//Bar 1 guards the goal, bar 2 in front of it is two paddles tall
+		const int barStartX[4] = { 50, SCREEN_WIDTH / 2 - 300, SCREEN_WIDTH - 100, SCREEN_WIDTH / 2 + 300 };
+		for (int i = 0; i < 4; ++i)
+		{
+			BarSlot slot;
+			slot.player = i < 2 ? 1 : 2;
+			slot.barId = i % 2 + 1;
+			slot.box = { barStartX[i], SCREEN_HEIGHT / 2 - 50, PBar::BAR_WIDTH, PBar::BAR_HEIGHT * slot.barId };
+			arena->mBarSlots.push_back(slot);
+		}
+
+		GoalArea goal;
+		goal.player = 1;
+		goal.box = { 0, SCREEN_HEIGHT / 2 - GOAL_HEIGHT / 2, GOAL_WIDTH, GOAL_HEIGHT };
+		arena->mGoals.push_back(goal);
+		goal.player = 2;
+		goal.box.x = SCREEN_WIDTH - GOAL_WIDTH;
+		arena->mGoals.push_back(goal);
+
+		//The top wall, then invisible walls just outside the screen
+		arena->mWalls.push_back({ 0, 0, SCREEN_WIDTH, PLAYFIELD_TOP });
+		arena->mWalls.push_back({ 0, SCREEN_HEIGHT, SCREEN_WIDTH, 100 });
+		arena->mWalls.push_back({ -100, 0, 100, SCREEN_HEIGHT });
+		arena->mWalls.push_back({ SCREEN_WIDTH, 0, 100, SCREEN_HEIGHT });
+
+		arena->buildCollision();
+		return ArenaHandle(arena);
+	}();
+	return standard;
+}
+
+ArenaHandle Arena::create(const std::vector<BarSlot>& barSlots, const std::vector<GoalArea>& goals, const std::vector<SDL_Rect>& walls)
+{
+	if ((int)barSlots.size() > MAX_BAR_SLOTS)
+	{
+		return NULL;
+	}
+
+	std::shared_ptr<Arena> arena(new Arena());
+	arena->mBarSlots = barSlots;
+	arena->mGoals = goals;
+	arena->mWalls = walls;
+	arena->buildCollision();
+	return ArenaHandle(arena);
+}
+
+ArenaHandle Arena::load(const char* path)
+{
+	FILE* file = fopen(path, "r");
+	if (file == NULL)
+	{
+		printf("Unable to open arena %s!\n", path);
+		return NULL;
+	}
+
+	std::shared_ptr<Arena> arena(new Arena());
+	bool success = true;
+	char line[MAX_LINE_LENGTH];
+	int lineNumber = 0;
+	while (success && fgets(line, sizeof(line), file) != NULL)
+	{
+		lineNumber += 1;
+
+		char kind[16];
+		if (sscanf(line, "%15s", kind) != 1 || kind[0] == '#')
+		{
+			continue;
+		}
+
+		SDL_Rect box;
+		if (strcmp(kind, "bar") == 0)
+		{
+			BarSlot slot;
+			success = sscanf(line, "%*s %d %d %d %d %d %d", &slot.player, &slot.barId, &box.x, &box.y, &box.w, &box.h) == 6
+				&& (slot.player == 1 || slot.player == 2) && (slot.barId == 1 || slot.barId == 2)
+				&& (int)arena->mBarSlots.size() < MAX_BAR_SLOTS;
+			slot.box = box;
+			arena->mBarSlots.push_back(slot);
+		}
+		else if (strcmp(kind, "goal") == 0)
+		{
+			GoalArea goal;
+			success = sscanf(line, "%*s %d %d %d %d %d", &goal.player, &box.x, &box.y, &box.w, &box.h) == 5
+				&& (goal.player == 1 || goal.player == 2);
+			goal.box = box;
+			arena->mGoals.push_back(goal);
+		}
+		else if (strcmp(kind, "wall") == 0)
+		{
+			success = sscanf(line, "%*s %d %d %d %d", &box.x, &box.y, &box.w, &box.h) == 4;
+			arena->mWalls.push_back(box);
+		}
+		else
+		{
+			success = false;
+		}
+
+		if (success && (box.w <= 0 || box.h <= 0))
+		{
+			success = false;
+		}
+		if (!success)
+		{
+			printf("Arena %s line %d is invalid: %s", path, lineNumber, line);
+		}
+	}
+	fclose(file);
+
+	if (success && arena->mGoals.empty())
+	{
+		printf("Arena %s has no goals!\n", path);
+		success = false;
+	}
+	if (!success)
+	{
+		return NULL;
+	}
+
+	arena->buildCollision();
+	return ArenaHandle(arena);
+}
+
+const std::vector<BarSlot>& Arena::getBarSlots() const
+{
+	return mBarSlots;
+}
+
+const std::vector<GoalArea>& Arena::getGoals() const
+{
+	return mGoals;
+}
+
+const std::vector<SDL_Rect>& Arena::getWalls() const
+{
+	return mWalls;
+}
+
+const std::vector<Obstacle>& Arena::getWallObstacles() const
+{
+	return mWallObstacles;
+}
+
+const StaticGrid& Arena::getWallGrid() const
+{
+	return mWallGrid;
+}
+
+void Arena::buildCollision()
+{
+	mWallObstacles.clear();
+	for (size_t i = 0; i < mWalls.size(); ++i)
+	{
+		Obstacle obstacle;
+		obstacle.box = mWalls[i];
+		obstacle.velX = 0;
+		obstacle.velY = 0;
+		mWallObstacles.push_back(obstacle);
+	}
+	mWallGrid.build(mWalls, SCREEN_WIDTH, SCREEN_HEIGHT, WALL_CELL_SIZE);
+}
@@ -0,0 +1,71 @@
+#pragma once
+#include <SDL.h>
+#include <memory>
+#include <vector>
+#include "Collision.h"
+#include "SpatialGrid.h"
+
+class Arena;
+
+//Arenas are shared by every match played on them, read only
+typedef std::shared_ptr<const Arena> ArenaHandle;
+
+//Where a bar starts, a player's bar 1 guards the goal and bar 2 plays in front
+struct BarSlot
+{
+	int player;
+	int barId;
+	SDL_Rect box;
+};
+
+//Area that scores for the other player when the ball gets inside
+struct GoalArea
+{
+	int player;
+	SDL_Rect box;
+};
+
+//Layout of a playfield: its walls, goals and bar slots
+//The walls' collision index is built once on load, so walls cost matches nothing per tick and threads can share an arena
+class Arena
+{
+public:
+	//Most bar slots an arena can have, hits on bars are tracked as bits
+	static const int MAX_BAR_SLOTS = 32;
+
+	//Side of the wall index's cells
+	static const int WALL_CELL_SIZE = 64;
+
+	//Gets the original layout, built once
+	static ArenaHandle getStandard();
+
+	//Builds an arena from its parts, NULL if there are too many bar slots
+	static ArenaHandle create(const std::vector<BarSlot>& barSlots, const std::vector<GoalArea>& goals, const std::vector<SDL_Rect>& walls);
+
+	//Loads a layout file, NULL if it can't be read or has errors
+	//One entry per line, blank lines and lines starting with # are skipped:
+	//bar <player> <bar id> <x> <y> <width> <height>
+	//goal <player> <x> <y> <width> <height>
+	//wall <x> <y> <width> <height>
+	static ArenaHandle load(const char* path);
+
+	//Gets the layout
+	const std::vector<BarSlot>& getBarSlots() const;
+	const std::vector<GoalArea>& getGoals() const;
+	const std::vector<SDL_Rect>& getWalls() const;
+
+	//Gets the walls as obstacles, and the index of them by wall number
+	const std::vector<Obstacle>& getWallObstacles() const;
+	const StaticGrid& getWallGrid() const;
+
+private:
+	//Builds the wall obstacles and their index once the layout is complete
+	void buildCollision();
+
+	std::vector<BarSlot> mBarSlots;
+	std::vector<GoalArea> mGoals;
+	std::vector<SDL_Rect> mWalls;
+
+	std::vector<Obstacle> mWallObstacles;
+	StaticGrid mWallGrid;
+};
@@ -0,0 +1,192 @@
+#include "AssetArchive.h"
+#include <stdio.h>
+#include <string.h>
+#include "TraceRecorder.h"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+AssetArchive::AssetArchive()
+{
+	mData = NULL;
+	mSize = 0;
+	mFileHandle = NULL;
+	mMappingHandle = NULL;
+}
+
+AssetArchive::~AssetArchive()
+{
+	close();
+}
+
+bool AssetArchive::open(const std::string& path)
+{
+	TraceScope trace("Open asset archive");
+
+	close();
+	if (!map(path))
+	{
+		return false;
+	}
+
+	//Check the header
+	const AssetArchiveHeader* header = (const AssetArchiveHeader*)mData;
+	if (mSize < sizeof(AssetArchiveHeader)
+		|| memcmp(header->magic, ASSET_ARCHIVE_MAGIC, sizeof(header->magic)) != 0
+		|| header->version != ASSET_ARCHIVE_VERSION
+		|| mSize < sizeof(AssetArchiveHeader) + (Uint64)header->totalEntries * sizeof(AssetArchiveEntry))
+	{
+		printf("%s is not a supported asset archive!\n", path.c_str());
+		close();
+		return false;
+	}
+
+	//Index the entries, skipping any whose data lies outside the file or doesn't hold their image
+	const AssetArchiveEntry* entries = (const AssetArchiveEntry*)(mData + sizeof(AssetArchiveHeader));
+	for (Uint32 i = 0; i < header->totalEntries; ++i)
+	{
+		const AssetArchiveEntry& entry = entries[i];
+		if (entry.offset > mSize || entry.size > mSize - entry.offset)
+		{
+			printf("Asset archive entry %.*s is cut off!\n", (int)sizeof(entry.name), entry.name);
+			continue;
+		}
+
+		//Images are read as pitch * height bytes of 32 bit rows, so the layout has to fit the entry's data
+		if (entry.type == ASSET_TYPE_IMAGE && (entry.width <= 0 || entry.height <= 0 || entry.pitch < (Sint64)entry.width * 4
+			|| (Uint64)entry.pitch * (Uint64)entry.height > entry.size))
+		{
+			printf("Asset archive image %.*s has a broken layout!\n", (int)sizeof(entry.name), entry.name);
+			continue;
+		}
+
+		std::string name(entry.name, strnlen(entry.name, sizeof(entry.name)));
+		mEntries[name] = &entry;
+	}
+	return true;
+}
+
+void AssetArchive::close()
+{
+	mEntries.clear();
+	unmap();
+}
+
+bool AssetArchive::isOpen()
+{
+	return mData != NULL;
+}
+
+const AssetArchiveEntry* AssetArchive::findEntry(const std::string& name)
+{
+	std::map<std::string, const AssetArchiveEntry*>::iterator entry = mEntries.find(name);
+	if (entry == mEntries.end())
+	{
+		return NULL;
+	}
+	return entry->second;
+}
+
+const void* AssetArchive::getData(const AssetArchiveEntry& entry)
+{
+	return mData + entry.offset;
+}
+
+#ifdef _WIN32
+bool AssetArchive::map(const std::string& path)
+{
+	HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+	if (file == INVALID_HANDLE_VALUE)
+	{
+		return false;
+	}
+
+	LARGE_INTEGER size;
+	if (!GetFileSizeEx(file, &size) || size.QuadPart == 0)
+	{
+		CloseHandle(file);
+		return false;
+	}
+
+	HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+	if (mapping == NULL)
+	{
+		CloseHandle(file);
+		return false;
+	}
+
+	const void* data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+	if (data == NULL)
+	{
+		CloseHandle(mapping);
+		CloseHandle(file);
+		return false;
+	}
+
+	mData = (const Uint8*)data;
+	mSize = (size_t)size.QuadPart;
+	mFileHandle = file;
+	mMappingHandle = mapping;
+	return true;
+}
+
+void AssetArchive::unmap()
+{
+	if (mData != NULL)
+	{
+		UnmapViewOfFile(mData);
+		CloseHandle((HANDLE)mMappingHandle);
+		CloseHandle((HANDLE)mFileHandle);
+	}
+	mData = NULL;
+	mSize = 0;
+	mFileHandle = NULL;
+	mMappingHandle = NULL;
+}
+#else
+bool AssetArchive::map(const std::string& path)
+{
+	int file = ::open(path.c_str(), O_RDONLY);
+	if (file < 0)
+	{
+		return false;
+	}
+
+	struct stat status;
+	if (fstat(file, &status) != 0 || status.st_size == 0)
+	{
+		::close(file);
+		return false;
+	}
+
+	//The mapping stays valid after the descriptor is closed
+	void* data = mmap(NULL, (size_t)status.st_size, PROT_READ, MAP_PRIVATE, file, 0);
+	::close(file);
+	if (data == MAP_FAILED)
+	{
+		return false;
+	}
+
+	mData = (const Uint8*)data;
+	mSize = (size_t)status.st_size;
+	return true;
+}
+
+void AssetArchive::unmap()
+{
+	if (mData != NULL)
+	{
+		munmap((void*)mData, mSize);
+	}
+	mData = NULL;
+	mSize = 0;
+}
+#endif
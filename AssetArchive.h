@@ -0,0 +1,89 @@
+#pragma once
+#include <SDL.h>
+#include <map>
+#include <string>
+
+//Layout of a packed asset archive, written by the Asset_Packer tool
+//Header, then the entry table, then the data of every entry aligned to ASSET_ARCHIVE_ALIGNMENT
+//Images are stored decoded and color keyed, in the pixel format the renderer takes as it is
+const char ASSET_ARCHIVE_MAGIC[4] = { 'P', 'P', 'A', 'K' };
+const Uint32 ASSET_ARCHIVE_VERSION = 1;
+const Uint32 ASSET_ARCHIVE_ALIGNMENT = 16;
+const Uint32 ASSET_ARCHIVE_IMAGE_FORMAT = SDL_PIXELFORMAT_ARGB8888;
+
+enum AssetType
+{
+	//Decoded pixels
+	ASSET_TYPE_IMAGE = 1,
+
+	//File bytes as they are, fonts for example
+	ASSET_TYPE_BLOB = 2
+};
+
+struct AssetArchiveHeader
+{
+	char magic[4];
+	Uint32 version;
+	Uint32 totalEntries;
+	Uint32 reserved;
+};
+
+struct AssetArchiveEntry
+{
+	//Path the asset was packed from, the name it's looked up by
+	char name[64];
+
+	Uint32 type;
+
+	//Image layout, unused for blobs
+	Uint32 format;
+	Sint32 width;
+	Sint32 height;
+	Sint32 pitch;
+	Uint32 reserved;
+
+	//Where the data is, from the start of the archive
+	Uint64 offset;
+	Uint64 size;
+};
+
+//Read only view of an archive mapped into memory, assets are used straight from the mapped bytes
+class AssetArchive
+{
+public:
+	//Initializes variables
+	AssetArchive();
+
+	//Unmaps the archive
+	~AssetArchive();
+
+	//Maps the archive at specified path and reads its entry table
+	bool open(const std::string& path);
+
+	//Unmaps the archive, everything taken from it must be gone by then
+	void close();
+
+	bool isOpen();
+
+	//Gets the entry packed from the path, NULL if there is none
+	const AssetArchiveEntry* findEntry(const std::string& name);
+
+	//Gets the mapped data of an entry
+	const void* getData(const AssetArchiveEntry& entry);
+
+private:
+	//Maps and unmaps the file
+	bool map(const std::string& path);
+	void unmap();
+
+	//The mapped file
+	const Uint8* mData;
+	size_t mSize;
+
+	//Platform handles of the mapping
+	void* mFileHandle;
+	void* mMappingHandle;
+
+	//Entries by name
+	std::map<std::string, const AssetArchiveEntry*> mEntries;
+};
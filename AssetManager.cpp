@@ -0,0 +1,309 @@
+#include "AssetManager.h"
+#include <stdio.h>
+#include "TextureAtlas.h"
+#include "AllocationTracker.h"
+
+AssetManager::AssetManager()
+{
+	//Initialize the statistics
+	mDecodeCount = 0;
+	mArchiveUploadCount = 0;
+	mReuseCount = 0;
+	mSavedDecodeBytes = 0;
+	mLoadedBytes = 0;
+}
+
+AssetManager::~AssetManager()
+{
+	std::map<std::string, SDL_Surface*>::iterator image;
+	for (image = mPrefetchedImages.begin(); image != mPrefetchedImages.end(); ++image)
+	{
+		SDL_FreeSurface(image->second);
+	}
+}
+
+void AssetManager::prefetch(const std::vector<std::string>& paths)
+{
+	//Archived assets are already decoded
+	std::vector<std::string> loosePaths;
+	for (size_t i = 0; i < paths.size(); ++i)
+	{
+		if (!mArchive.isOpen() || mArchive.findEntry(paths[i]) == NULL)
+		{
+			loosePaths.push_back(paths[i]);
+		}
+	}
+	mLoader.start(loosePaths);
+}
+
+bool AssetManager::updatePrefetch()
+{
+	LoadedAsset asset;
+	while (mLoader.poll(asset))
+	{
+		//Failed assets are loaded again the usual way, which reports the error
+		if (asset.surface != NULL)
+		{
+			mPrefetchedImages[asset.path] = asset.surface;
+		}
+		else if (asset.success)
+		{
+			mPrefetchedFiles[asset.path].swap(asset.fileData);
+		}
+	}
+	return mLoader.isDone();
+}
+
+float AssetManager::getPrefetchProgress()
+{
+	int total = mLoader.getTotalCount();
+	return total > 0 ? (float)mLoader.getFinishedCount() / total : 1.f;
+}
+
+SDL_Surface* AssetManager::takePrefetchedImage(const std::string& path)
+{
+	std::map<std::string, SDL_Surface*>::iterator image = mPrefetchedImages.find(path);
+	if (image == mPrefetchedImages.end())
+	{
+		return NULL;
+	}
+
+	SDL_Surface* surface = image->second;
+	mPrefetchedImages.erase(image);
+	return surface;
+}
+
+TextureHandle AssetManager::findTexture(const std::string& path)
+{
+	//Hand out the cached texture while someone still holds it
+	std::map<std::string, std::weak_ptr<LTexture>>::iterator cached = mTextures.find(path);
+	if (cached != mTextures.end())
+	{
+		TextureHandle texture = cached->second.lock();
+		if (texture)
+		{
+			mReuseCount += 1;
+			mSavedDecodeBytes += getTextureBytes(*texture);
+			return texture;
+		}
+	}
+	return TextureHandle();
+}
+
+TextureHandle AssetManager::getTexture(const std::string& path)
+{
+	TextureHandle cached = findTexture(path);
+	if (cached)
+	{
+		return cached;
+	}
+
+	//Upload the archived pixels or the prefetched image, or decode and upload the image
+	TextureHandle texture = std::make_shared<LTexture>();
+	const AssetArchiveEntry* archived = findArchivedImage(path);
+	SDL_Surface* prefetched = takePrefetchedImage(path);
+	bool success = false;
+	if (archived != NULL)
+	{
+		success = texture->loadFromPixels(mArchive.getData(*archived), archived->width, archived->height, archived->pitch, archived->format);
+	}
+	else if (prefetched != NULL)
+	{
+		success = texture->loadFromSurface(prefetched);
+		SDL_FreeSurface(prefetched);
+	}
+	else
+	{
+		success = texture->loadFromFile(path);
+	}
+	if (!success)
+	{
+		printf("Asset manager failed to load %s!\n", path.c_str());
+		return texture;
+	}
+
+	//Archived pixels were decoded when the archive was packed
+	if (archived != NULL)
+	{
+		mArchiveUploadCount += 1;
+	}
+	else
+	{
+		mDecodeCount += 1;
+	}
+	mLoadedBytes += getTextureBytes(*texture);
+	mTextures[path] = texture;
+	return texture;
+}
+
+std::vector<TextureHandle> AssetManager::getPackedTextures(const std::vector<std::string>& paths)
+{
+	std::vector<TextureHandle> textures(paths.size());
+
+	//Decode whatever isn't loaded yet
+	TextureAtlas atlas;
+	std::vector<bool> isArchived(paths.size(), false);
+	for (size_t i = 0; i < paths.size(); ++i)
+	{
+		textures[i] = findTexture(paths[i]);
+		if (textures[i])
+		{
+			continue;
+		}
+
+		//Archived pixels are blitted into the atlas straight from the mapping
+		const AssetArchiveEntry* archived = findArchivedImage(paths[i]);
+		if (archived != NULL)
+		{
+			SDL_Surface* surface = SDL_CreateRGBSurfaceWithFormatFrom((void*)mArchive.getData(*archived),
+				archived->width, archived->height, 32, archived->pitch, archived->format);
+			if (surface != NULL)
+			{
+				AllocationTracker::countSurface();
+				atlas.addSurface(paths[i], surface);
+				isArchived[i] = true;
+				continue;
+			}
+		}
+
+		//The atlas takes the prefetched surface as it is
+		SDL_Surface* prefetched = takePrefetchedImage(paths[i]);
+		if (prefetched != NULL)
+		{
+			atlas.addSurface(paths[i], prefetched);
+			continue;
+		}
+
+		if (!atlas.addImage(paths[i]))
+		{
+			printf("Asset manager failed to load %s!\n", paths[i].c_str());
+		}
+	}
+
+	if (!atlas.pack())
+	{
+		printf("Asset manager failed to upload atlas!\n");
+	}
+
+	//Textures that failed stay empty, same as getTexture
+	for (size_t i = 0; i < paths.size(); ++i)
+	{
+		if (textures[i])
+		{
+			continue;
+		}
+
+		textures[i] = atlas.getTexture(paths[i]);
+		if (textures[i])
+		{
+			if (isArchived[i])
+			{
+				mArchiveUploadCount += 1;
+			}
+			else
+			{
+				mDecodeCount += 1;
+			}
+			mLoadedBytes += getTextureBytes(*textures[i]);
+			mTextures[paths[i]] = textures[i];
+		}
+		else
+		{
+			textures[i] = std::make_shared<LTexture>();
+		}
+	}
+	return textures;
+}
+
+bool AssetManager::openArchive(const std::string& path)
+{
+	return mArchive.open(path);
+}
+
+TTF_Font* AssetManager::openFont(const std::string& path, int pointSize)
+{
+	const AssetArchiveEntry* archived = mArchive.isOpen() ? mArchive.findEntry(path) : NULL;
+	if (archived == NULL || archived->type != ASSET_TYPE_BLOB)
+	{
+		//Prefetched bytes stay alive with the asset manager
+		std::map<std::string, std::vector<Uint8>>::iterator prefetched = mPrefetchedFiles.find(path);
+		if (prefetched == mPrefetchedFiles.end() || prefetched->second.empty())
+		{
+			return TTF_OpenFont(path.c_str(), pointSize);
+		}
+		SDL_RWops* file = SDL_RWFromConstMem(prefetched->second.data(), (int)prefetched->second.size());
+		return TTF_OpenFontRW(file, 1, pointSize);
+	}
+
+	//The font reads glyphs from the mapping for as long as it's open
+	SDL_RWops* file = SDL_RWFromConstMem(mArchive.getData(*archived), (int)archived->size);
+	return TTF_OpenFontRW(file, 1, pointSize);
+}
+
+const AssetArchiveEntry* AssetManager::findArchivedImage(const std::string& path)
+{
+	if (!mArchive.isOpen())
+	{
+		return NULL;
+	}
+
+	const AssetArchiveEntry* entry = mArchive.findEntry(path);
+	if (entry == NULL || entry->type != ASSET_TYPE_IMAGE)
+	{
+		return NULL;
+	}
+	return entry;
+}
+
+void AssetManager::collect()
+{
+	std::map<std::string, std::weak_ptr<LTexture>>::iterator entry = mTextures.begin();
+	while (entry != mTextures.end())
+	{
+		if (entry->second.expired())
+		{
+			entry = mTextures.erase(entry);
+		}
+		else
+		{
+			++entry;
+		}
+	}
+}
+
+int AssetManager::getDecodeCount()
+{
+	return mDecodeCount;
+}
+
+int AssetManager::getArchiveUploadCount()
+{
+	return mArchiveUploadCount;
+}
+
+int AssetManager::getReuseCount()
+{
+	return mReuseCount;
+}
+
+size_t AssetManager::getSavedDecodeBytes()
+{
+	return mSavedDecodeBytes;
+}
+
+size_t AssetManager::getLoadedBytes()
+{
+	return mLoadedBytes;
+}
+
+void AssetManager::printStats()
+{
+	printf("Assets: %d decodes, %d archive uploads, %d reused (%u KB of texture memory saved), %u KB loaded\n",
+		mDecodeCount, mArchiveUploadCount, mReuseCount, (unsigned)(mSavedDecodeBytes / 1024), (unsigned)(mLoadedBytes / 1024));
+}
+
+size_t AssetManager::getTextureBytes(LTexture& texture)
+{
+	//Textures are created from 32 bit surfaces
+	return (size_t)texture.getWidth() * texture.getHeight() * 4;
+}
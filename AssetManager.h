@@ -0,0 +1,90 @@
+#pragma once
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+#include "LTexture.h"
+#include "AssetArchive.h"
+#include "AsyncLoader.h"
+
+//Texture cache keyed by path, every image is decoded and uploaded once
+class AssetManager
+{
+public:
+	//Initializes variables
+	AssetManager();
+
+	//Frees prefetched assets nobody asked for
+	~AssetManager();
+
+	//Maps a packed archive, assets in it are loaded from there instead of their loose files
+	bool openArchive(const std::string& path);
+
+	//Starts decoding the loose files among the paths on a worker thread
+	//Later loads of those paths use the decoded result instead of touching the disk
+	//Only the first call prefetches, the worker is used once
+	void prefetch(const std::vector<std::string>& paths);
+
+	//Takes the assets the worker finished, never blocks, returns true once all are in
+	bool updatePrefetch();
+
+	//Gets the fraction of prefetched assets the worker finished
+	float getPrefetchProgress();
+
+	//Gets the texture at specified path, loading it only when no handle to it is alive
+	TextureHandle getTexture(const std::string& path);
+
+	//Gets the textures at specified paths, the ones not loaded yet are packed into a shared atlas
+	std::vector<TextureHandle> getPackedTextures(const std::vector<std::string>& paths);
+
+	//Opens the font at specified path, the font must be closed before the asset manager goes away
+	TTF_Font* openFont(const std::string& path, int pointSize);
+
+	//Drops cache entries whose handles were all released
+	void collect();
+
+	//Gets cache statistics
+	int getDecodeCount();
+	int getArchiveUploadCount();
+	int getReuseCount();
+	size_t getSavedDecodeBytes();
+	size_t getLoadedBytes();
+
+	//Prints cache statistics
+	void printStats();
+
+private:
+	//Estimated GPU memory of a texture
+	static size_t getTextureBytes(LTexture& texture);
+
+	//Gets a cached texture that is still alive, counting the reuse
+	TextureHandle findTexture(const std::string& path);
+
+	//Gets the archive entry of an image, NULL if it has to come from its file
+	const AssetArchiveEntry* findArchivedImage(const std::string& path);
+
+	//Takes the prefetched surface of an image, NULL if it wasn't prefetched
+	SDL_Surface* takePrefetchedImage(const std::string& path);
+
+	//Mapped archive, may be closed
+	AssetArchive mArchive;
+
+	//Worker decoding the prefetched files
+	AsyncLoader mLoader;
+
+	//Prefetched images waiting to be uploaded, owned until then
+	std::map<std::string, SDL_Surface*> mPrefetchedImages;
+
+	//Prefetched file bytes, kept for as long as a font may read them
+	std::map<std::string, std::vector<Uint8>> mPrefetchedFiles;
+
+	//Cached textures, the cache itself doesn't keep them alive
+	std::map<std::string, std::weak_ptr<LTexture>> mTextures;
+
+	//Statistics, images uploaded straight from the archive aren't decodes
+	int mDecodeCount;
+	int mArchiveUploadCount;
+	int mReuseCount;
+	size_t mSavedDecodeBytes;
+	size_t mLoadedBytes;
+};
@@ -0,0 +1,191 @@
+//Asset packer, decodes images once and writes them with the other assets into one archive the game maps at startup
+
+//No SDL_main, the packer is a plain console tool
+#define SDL_MAIN_HANDLED
+#include <SDL.h>
+#include <SDL_image.h>
+#include <stdio.h>
+#include <string.h>
+#include <string>
+#include <vector>
+#include "AssetArchive.h"
+
+//Assets the game loads, packed when no paths are given
+static const char* DEFAULT_ASSETS[] = {
+	"image/ball.png",
+	"image/paddleBlu.png",
+	"image/paddleRed.png",
+	"image/groundGrass_mown1.png",
+	"font/Cartos.ttf"
+};
+
+//Checks whether the path ends in an image extension SDL_image reads
+static bool isImagePath(const std::string& path)
+{
+	const char* extensions[] = { ".png", ".bmp", ".jpg", ".tga" };
+	for (size_t i = 0; i < sizeof(extensions) / sizeof(extensions[0]); ++i)
+	{
+		size_t length = strlen(extensions[i]);
+		if (path.size() >= length && SDL_strcasecmp(path.c_str() + path.size() - length, extensions[i]) == 0)
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+//Decodes an image into archive pixels, color keyed the same way as LTexture::loadFromFile
+static bool packImage(const std::string& path, AssetArchiveEntry& entry, std::vector<Uint8>& data)
+{
+	SDL_Surface* loadedSurface = IMG_Load(path.c_str());
+	if (loadedSurface == NULL)
+	{
+		printf("Unable to load image %s! SDL_image Error: %s\n", path.c_str(), IMG_GetError());
+		return false;
+	}
+
+	//Converting to a format with alpha turns the color key into transparency
+	SDL_SetColorKey(loadedSurface, SDL_TRUE, SDL_MapRGB(loadedSurface->format, 0, 0xFF, 0xFF));
+	SDL_Surface* converted = SDL_ConvertSurfaceFormat(loadedSurface, ASSET_ARCHIVE_IMAGE_FORMAT, 0);
+	SDL_FreeSurface(loadedSurface);
+	if (converted == NULL)
+	{
+		printf("Unable to convert image %s! SDL Error: %s\n", path.c_str(), SDL_GetError());
+		return false;
+	}
+
+	//Rows are stored tightly packed
+	entry.type = ASSET_TYPE_IMAGE;
+	entry.format = ASSET_ARCHIVE_IMAGE_FORMAT;
+	entry.width = converted->w;
+	entry.height = converted->h;
+	entry.pitch = converted->w * 4;
+
+	SDL_LockSurface(converted);
+	data.resize((size_t)entry.pitch * entry.height);
+	for (int row = 0; row < converted->h; ++row)
+	{
+		memcpy(&data[(size_t)row * entry.pitch], (Uint8*)converted->pixels + row * converted->pitch, entry.pitch);
+	}
+	SDL_UnlockSurface(converted);
+	SDL_FreeSurface(converted);
+	return true;
+}
+
+//Reads a file as it is
+static bool packBlob(const std::string& path, AssetArchiveEntry& entry, std::vector<Uint8>& data)
+{
+	size_t size = 0;
+	void* bytes = SDL_LoadFile(path.c_str(), &size);
+	if (bytes == NULL)
+	{
+		printf("Unable to read %s! SDL Error: %s\n", path.c_str(), SDL_GetError());
+		return false;
+	}
+
+	entry.type = ASSET_TYPE_BLOB;
+	data.assign((Uint8*)bytes, (Uint8*)bytes + size);
+	SDL_free(bytes);
+	return true;
+}
+
+int main(int argc, char* args[])
+{
+	//packer <archive> [asset paths]
+	if (argc < 2)
+	{
+		printf("Usage: Asset_Packer <archive> [asset paths]\n");
+		return 1;
+	}
+
+	std::vector<std::string> paths;
+	for (int i = 2; i < argc; ++i)
+	{
+		paths.push_back(args[i]);
+	}
+	if (paths.empty())
+	{
+		paths.assign(DEFAULT_ASSETS, DEFAULT_ASSETS + sizeof(DEFAULT_ASSETS) / sizeof(DEFAULT_ASSETS[0]));
+	}
+
+	int imgFlags = IMG_INIT_PNG | IMG_INIT_JPG;
+	IMG_Init(imgFlags);
+
+	//Read everything first, offsets depend on the entry count
+	std::vector<AssetArchiveEntry> entries;
+	std::vector<std::vector<Uint8>> blobs;
+	for (size_t i = 0; i < paths.size(); ++i)
+	{
+		AssetArchiveEntry entry;
+		memset(&entry, 0, sizeof(entry));
+		if (paths[i].size() >= sizeof(entry.name))
+		{
+			printf("Asset path %s is too long!\n", paths[i].c_str());
+			return 1;
+		}
+		memcpy(entry.name, paths[i].c_str(), paths[i].size());
+
+		std::vector<Uint8> data;
+		bool success = isImagePath(paths[i]) ? packImage(paths[i], entry, data) : packBlob(paths[i], entry, data);
+		if (!success)
+		{
+			return 1;
+		}
+
+		entry.size = data.size();
+		entries.push_back(entry);
+		blobs.push_back(data);
+	}
+
+	//Lay out the data after the entry table
+	Uint64 offset = sizeof(AssetArchiveHeader) + entries.size() * sizeof(AssetArchiveEntry);
+	for (size_t i = 0; i < entries.size(); ++i)
+	{
+		offset = (offset + ASSET_ARCHIVE_ALIGNMENT - 1) / ASSET_ARCHIVE_ALIGNMENT * ASSET_ARCHIVE_ALIGNMENT;
+		entries[i].offset = offset;
+		offset += entries[i].size;
+	}
+
+	FILE* file = fopen(args[1], "wb");
+	if (file == NULL)
+	{
+		printf("Unable to open %s for writing!\n", args[1]);
+		return 1;
+	}
+
+	AssetArchiveHeader header;
+	memset(&header, 0, sizeof(header));
+	memcpy(header.magic, ASSET_ARCHIVE_MAGIC, sizeof(header.magic));
+	header.version = ASSET_ARCHIVE_VERSION;
+	header.totalEntries = (Uint32)entries.size();
+	fwrite(&header, sizeof(header), 1, file);
+	if (!entries.empty())
+	{
+		fwrite(entries.data(), sizeof(AssetArchiveEntry), entries.size(), file);
+	}
+
+	//Pad up to every entry's offset, then write its data
+	static const Uint8 padding[ASSET_ARCHIVE_ALIGNMENT] = {};
+	Uint64 written = sizeof(AssetArchiveHeader) + entries.size() * sizeof(AssetArchiveEntry);
+	for (size_t i = 0; i < entries.size(); ++i)
+	{
+		fwrite(padding, 1, (size_t)(entries[i].offset - written), file);
+		if (!blobs[i].empty())
+		{
+			fwrite(blobs[i].data(), 1, blobs[i].size(), file);
+		}
+		written = entries[i].offset + entries[i].size;
+	}
+
+	bool success = ferror(file) == 0;
+	fclose(file);
+	if (!success)
+	{
+		printf("Unable to write %s!\n", args[1]);
+		return 1;
+	}
+
+	printf("Packed %d assets into %s (%llu KB)\n", (int)entries.size(), args[1], (unsigned long long)(written / 1024));
+	IMG_Quit();
+	return 0;
+}
@@ -0,0 +1,136 @@
+#include "AsyncLoader.h"
+#include <stdio.h>
+#include <SDL_image.h>
+#include "TraceRecorder.h"
+
+AsyncLoader::AsyncLoader()
+	: mFinished(0), mTaken(0)
+{
+}
+
+AsyncLoader::~AsyncLoader()
+{
+	if (mThread.joinable())
+	{
+		mThread.join();
+	}
+
+	for (size_t i = mTaken; i < mAssets.size(); ++i)
+	{
+		if (mAssets[i].surface != NULL)
+		{
+			SDL_FreeSurface(mAssets[i].surface);
+		}
+	}
+}
+
+bool AsyncLoader::start(const std::vector<std::string>& paths)
+{
+	//The worker may still be reading the assets of the first start
+	if (mThread.joinable())
+	{
+		printf("Asset loader was already started!\n");
+		return false;
+	}
+
+	mAssets.resize(paths.size());
+	for (size_t i = 0; i < paths.size(); ++i)
+	{
+		mAssets[i].path = paths[i];
+		mAssets[i].surface = NULL;
+		mAssets[i].success = false;
+	}
+
+	mThread = std::thread(&AsyncLoader::run, this);
+	return true;
+}
+
+bool AsyncLoader::isImagePath(const std::string& path)
+{
+	const char* extensions[] = { ".png", ".bmp", ".jpg", ".tga" };
+	for (size_t i = 0; i < sizeof(extensions) / sizeof(extensions[0]); ++i)
+	{
+		size_t length = SDL_strlen(extensions[i]);
+		if (path.size() >= length && SDL_strcasecmp(path.c_str() + path.size() - length, extensions[i]) == 0)
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+void AsyncLoader::run()
+{
+	TraceRecorder::setThreadName("Asset loader");
+
+	for (size_t i = 0; i < mAssets.size(); ++i)
+	{
+		LoadedAsset& asset = mAssets[i];
+		if (isImagePath(asset.path))
+		{
+			TraceScope trace("Decode image");
+			asset.surface = IMG_Load(asset.path.c_str());
+			if (asset.surface == NULL)
+			{
+				printf("Unable to load image %s! SDL_image Error: %s\n", asset.path.c_str(), IMG_GetError());
+			}
+			else
+			{
+				//Color key image, the same way as LTexture::loadFromFile
+				SDL_SetColorKey(asset.surface, SDL_TRUE, SDL_MapRGB(asset.surface->format, 0, 0xFF, 0xFF));
+				asset.success = true;
+			}
+		}
+		else
+		{
+			TraceScope trace("Read file");
+			size_t size = 0;
+			void* bytes = SDL_LoadFile(asset.path.c_str(), &size);
+			if (bytes == NULL)
+			{
+				printf("Unable to read %s! SDL Error: %s\n", asset.path.c_str(), SDL_GetError());
+			}
+			else
+			{
+				asset.fileData.assign((Uint8*)bytes, (Uint8*)bytes + size);
+				SDL_free(bytes);
+				asset.success = true;
+			}
+		}
+
+		//Publish the asset, the main thread reads it only after seeing the new count
+		mFinished.store((int)i + 1, std::memory_order_release);
+	}
+}
+
+bool AsyncLoader::poll(LoadedAsset& asset)
+{
+	if (mTaken >= mFinished.load(std::memory_order_acquire))
+	{
+		return false;
+	}
+
+	LoadedAsset& finished = mAssets[mTaken];
+	asset.path = finished.path;
+	asset.surface = finished.surface;
+	asset.fileData.swap(finished.fileData);
+	asset.success = finished.success;
+	finished.surface = NULL;
+	mTaken += 1;
+	return true;
+}
+
+int AsyncLoader::getFinishedCount()
+{
+	return mFinished.load(std::memory_order_acquire);
+}
+
+int AsyncLoader::getTotalCount()
+{
+	return (int)mAssets.size();
+}
+
+bool AsyncLoader::isDone()
+{
+	return mTaken == (int)mAssets.size();
+}
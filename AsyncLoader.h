@@ -0,0 +1,64 @@
+#pragma once
+#include <SDL.h>
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+//An asset decoded off the main thread
+struct LoadedAsset
+{
+	std::string path;
+
+	//Decoded and color keyed image, NULL for other files or on failure
+	SDL_Surface* surface;
+
+	//Bytes of a file that isn't an image, fonts for example
+	std::vector<Uint8> fileData;
+
+	bool success;
+};
+
+//Decodes images and reads files on a worker thread, in the order they were given
+//Finished assets are published through an atomic counter, taking them never blocks
+//Uploading is left to the caller, textures can only be created on the render thread
+//A loader is used once, it loads a single list of paths
+class AsyncLoader
+{
+public:
+	//Initializes variables
+	AsyncLoader();
+
+	//Waits for the worker and frees whatever wasn't taken
+	~AsyncLoader();
+
+	//Starts loading the paths on the worker thread, returns false if the loader was already started
+	bool start(const std::vector<std::string>& paths);
+
+	//Takes the next finished asset, returns false if it isn't ready yet
+	//The caller owns the surface of a taken asset
+	bool poll(LoadedAsset& asset);
+
+	//Gets progress
+	int getFinishedCount();
+	int getTotalCount();
+	bool isDone();
+
+private:
+	//Worker thread body
+	void run();
+
+	//Checks whether the path ends in an image extension SDL_image reads
+	static bool isImagePath(const std::string& path);
+
+	//Results in path order, the worker fills them, the main thread takes them
+	std::vector<LoadedAsset> mAssets;
+
+	//Assets the worker finished, everything below is safe to read
+	std::atomic<int> mFinished;
+
+	//Assets the main thread took
+	int mTaken;
+
+	std::thread mThread;
+};
@@ -0,0 +1,220 @@
+#include "BallKernel.h"
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define BALL_KERNEL_X86
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+#endif
+
+//MSVC compiles any intrinsic as is, GCC and Clang need the functions using them marked
+#if defined(BALL_KERNEL_X86) && !defined(_MSC_VER)
+#define TARGET_SSE2 __attribute__((target("sse2")))
+#define TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define TARGET_SSE2
+#define TARGET_AVX2
+#endif
+
+//Reference kernel, also finishes the balls left over by the vector kernels
+static void stepBallsScalar(int* posX, int* posY, int* prevX, int* prevY, int* velX, int* velY, int first, int totalBalls, const BallBounds& bounds)
+{
+	for (int i = first; i < totalBalls; ++i)
+	{
+		prevX[i] = posX[i];
+		prevY[i] = posY[i];
+
+		int x = posX[i] + velX[i];
+		if (x < bounds.minX)
+		{
+			x = 2 * bounds.minX - x;
+			velX[i] = -velX[i];
+		}
+		else if (x > bounds.maxX)
+		{
+			x = 2 * bounds.maxX - x;
+			velX[i] = -velX[i];
+		}
+		posX[i] = x;
+
+		int y = posY[i] + velY[i];
+		if (y < bounds.minY)
+		{
+			y = 2 * bounds.minY - y;
+			velY[i] = -velY[i];
+		}
+		else if (y > bounds.maxY)
+		{
+			y = 2 * bounds.maxY - y;
+			velY[i] = -velY[i];
+		}
+		posY[i] = y;
+	}
+}
+
+#ifdef BALL_KERNEL_X86
+//Steps one axis of four balls, SSE2 has no blend so lanes are selected with masks
+TARGET_SSE2 static inline void stepAxisSse2(int* pos, int* prev, int* vel, __m128i minPos, __m128i maxPos)
+{
+	__m128i start = _mm_loadu_si128((const __m128i*)pos);
+	__m128i velocity = _mm_loadu_si128((const __m128i*)vel);
+	_mm_storeu_si128((__m128i*)prev, start);
+
+	__m128i moved = _mm_add_epi32(start, velocity);
+	__m128i under = _mm_cmplt_epi32(moved, minPos);
+	__m128i over = _mm_cmpgt_epi32(moved, maxPos);
+
+	//Reflected position is 2 * bound - position, with the bound of whichever side was crossed
+	__m128i bound = _mm_or_si128(_mm_and_si128(under, minPos), _mm_and_si128(over, maxPos));
+	__m128i reflected = _mm_sub_epi32(_mm_add_epi32(bound, bound), moved);
+	__m128i crossed = _mm_or_si128(under, over);
+	moved = _mm_or_si128(_mm_and_si128(crossed, reflected), _mm_andnot_si128(crossed, moved));
+
+	//Negate the crossed lanes, -v is (v ^ -1) - -1
+	velocity = _mm_sub_epi32(_mm_xor_si128(velocity, crossed), crossed);
+
+	_mm_storeu_si128((__m128i*)pos, moved);
+	_mm_storeu_si128((__m128i*)vel, velocity);
+}
+
+TARGET_SSE2 static void stepBallsSse2(int* posX, int* posY, int* prevX, int* prevY, int* velX, int* velY, int totalBalls, const BallBounds& bounds)
+{
+	__m128i minX = _mm_set1_epi32(bounds.minX);
+	__m128i maxX = _mm_set1_epi32(bounds.maxX);
+	__m128i minY = _mm_set1_epi32(bounds.minY);
+	__m128i maxY = _mm_set1_epi32(bounds.maxY);
+
+	int i = 0;
+	for (; i + 4 <= totalBalls; i += 4)
+	{
+		stepAxisSse2(posX + i, prevX + i, velX + i, minX, maxX);
+		stepAxisSse2(posY + i, prevY + i, velY + i, minY, maxY);
+	}
+	stepBallsScalar(posX, posY, prevX, prevY, velX, velY, i, totalBalls, bounds);
+}
+
+//Steps one axis of eight balls
+TARGET_AVX2 static inline void stepAxisAvx2(int* pos, int* prev, int* vel, __m256i minPos, __m256i maxPos)
+{
+	__m256i start = _mm256_loadu_si256((const __m256i*)pos);
+	__m256i velocity = _mm256_loadu_si256((const __m256i*)vel);
+	_mm256_storeu_si256((__m256i*)prev, start);
+
+	__m256i moved = _mm256_add_epi32(start, velocity);
+	__m256i under = _mm256_cmpgt_epi32(minPos, moved);
+	__m256i over = _mm256_cmpgt_epi32(moved, maxPos);
+
+	__m256i bound = _mm256_blendv_epi8(maxPos, minPos, under);
+	__m256i reflected = _mm256_sub_epi32(_mm256_add_epi32(bound, bound), moved);
+	__m256i crossed = _mm256_or_si256(under, over);
+	moved = _mm256_blendv_epi8(moved, reflected, crossed);
+	velocity = _mm256_sub_epi32(_mm256_xor_si256(velocity, crossed), crossed);
+
+	_mm256_storeu_si256((__m256i*)pos, moved);
+	_mm256_storeu_si256((__m256i*)vel, velocity);
+}
+
+TARGET_AVX2 static void stepBallsAvx2(int* posX, int* posY, int* prevX, int* prevY, int* velX, int* velY, int totalBalls, const BallBounds& bounds)
+{
+	__m256i minX = _mm256_set1_epi32(bounds.minX);
+	__m256i maxX = _mm256_set1_epi32(bounds.maxX);
+	__m256i minY = _mm256_set1_epi32(bounds.minY);
+	__m256i maxY = _mm256_set1_epi32(bounds.maxY);
+
+	int i = 0;
+	for (; i + 8 <= totalBalls; i += 8)
+	{
+		stepAxisAvx2(posX + i, prevX + i, velX + i, minX, maxX);
+		stepAxisAvx2(posY + i, prevY + i, velY + i, minY, maxY);
+	}
+	stepBallsScalar(posX, posY, prevX, prevY, velX, velY, i, totalBalls, bounds);
+}
+
+//Checks the CPU and the OS, which has to save the AVX registers on a thread switch
+static bool isAvx2Supported()
+{
+	int info[4] = { 0, 0, 0, 0 };
+#ifdef _MSC_VER
+	__cpuid(info, 0);
+	if (info[0] < 7)
+	{
+		return false;
+	}
+	__cpuid(info, 1);
+	bool osSavesAvx = (info[2] & (1 << 27)) != 0 && (info[2] & (1 << 28)) != 0 && (_xgetbv(0) & 6) == 6;
+	__cpuidex(info, 7, 0);
+#else
+	unsigned int eax = 0, ebx = 0, ecx = 0, edx = 0;
+	if (__get_cpuid_max(0, NULL) < 7)
+	{
+		return false;
+	}
+	__get_cpuid(1, &eax, &ebx, &ecx, &edx);
+	bool osSavesAvx = false;
+	if ((ecx & (1u << 27)) != 0 && (ecx & (1u << 28)) != 0)
+	{
+		unsigned int xcrLow, xcrHigh;
+		__asm__("xgetbv" : "=a"(xcrLow), "=d"(xcrHigh) : "c"(0));
+		osSavesAvx = (xcrLow & 6) == 6;
+	}
+	__cpuid_count(7, 0, eax, ebx, ecx, edx);
+	info[1] = (int)ebx;
+#endif
+	return osSavesAvx && (info[1] & (1 << 5)) != 0;
+}
+#endif
+
+BallKernel getBestBallKernel()
+{
+#ifdef BALL_KERNEL_X86
+	//SSE2 is part of x64, and every x86 CPU still around has it
+	static const BallKernel best = isAvx2Supported() ? BALL_KERNEL_AVX2 : BALL_KERNEL_SSE2;
+	return best;
+#else
+	return BALL_KERNEL_SCALAR;
+#endif
+}
+
+//Kernel in use, picked before main runs so threads only ever read it
+static BallKernel selectedKernel = getBestBallKernel();
+
+void setBallKernel(BallKernel kernel)
+{
+	selectedKernel = kernel <= getBestBallKernel() ? kernel : getBestBallKernel();
+}
+
+BallKernel getBallKernel()
+{
+	return selectedKernel;
+}
+
+void stepBalls(int* posX, int* posY, int* prevX, int* prevY, int* velX, int* velY, int totalBalls, const BallBounds& bounds)
+{
+	switch (getBallKernel())
+	{
+#ifdef BALL_KERNEL_X86
+	case BALL_KERNEL_AVX2:
+		stepBallsAvx2(posX, posY, prevX, prevY, velX, velY, totalBalls, bounds);
+		break;
+	case BALL_KERNEL_SSE2:
+		stepBallsSse2(posX, posY, prevX, prevY, velX, velY, totalBalls, bounds);
+		break;
+#endif
+	default:
+		stepBallsScalar(posX, posY, prevX, prevY, velX, velY, 0, totalBalls, bounds);
+		break;
+	}
+}
+
+const char* getBallKernelName(BallKernel kernel)
+{
+	switch (kernel)
+	{
+	case BALL_KERNEL_AVX2: return "AVX2";
+	case BALL_KERNEL_SSE2: return "SSE2";
+	default: return "Scalar";
+	}
+}
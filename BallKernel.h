@@ -0,0 +1,34 @@
+#pragma once
+
+//Instruction sets the ball kernel can run on
+enum BallKernel
+{
+	BALL_KERNEL_SCALAR = 0,
+	BALL_KERNEL_SSE2 = 1,
+	BALL_KERNEL_AVX2 = 2
+};
+
+//Box the top left corner of a ball stays in
+struct BallBounds
+{
+	int minX;
+	int minY;
+	int maxX;
+	int maxY;
+};
+
+//Moves balls by their velocity and reflects them off the bounds, saving where they started in prev
+//Works on plain arrays of a structure of arrays, all kernels give exactly the same result
+//Velocities must be smaller than the bounds, so a ball reflects at most once per axis
+void stepBalls(int* posX, int* posY, int* prevX, int* prevY, int* velX, int* velY, int totalBalls, const BallBounds& bounds);
+
+//Gets the widest kernel the CPU supports, checked once
+BallKernel getBestBallKernel();
+
+//Picks the kernel stepBalls uses, the best one by default, falls back if the CPU lacks it
+//Call before any thread steps balls
+void setBallKernel(BallKernel kernel);
+BallKernel getBallKernel();
+
+//Gets kernel display name
+const char* getBallKernelName(BallKernel kernel);
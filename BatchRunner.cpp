@@ -0,0 +1,123 @@
+#include "BatchRunner.h"
+#include <stdio.h>
+#include <chrono>
+#include "ThreadPool.h"
+#include "AllocationTracker.h"
+
+MatchResult runMatch(const MatchConfig& config)
+{
+	//Everything the match touches lives on this stack
+	Match match;
+	if (config.arena != NULL)
+	{
+		match.setArena(config.arena);
+	}
+	match.setSpeedCurve(config.speedCurve);
+	match.setSeed(config.seed);
+	match.setExtraBalls(config.extraBalls);
+	match.reset();
+
+	BotController p1Bot(1, config.p1Policy);
+	BotController p2Bot(2, config.p2Policy);
+
+	//Once the first tick is done the match is in its steady state and shouldn't touch the heap
+	bool isSteady = false;
+	AllocationCounts steadyStart = AllocationCounts();
+	while (!match.isOver() && match.getTickCount() < config.maxTicks)
+	{
+		if (!isSteady && match.getTickCount() > 0)
+		{
+			isSteady = true;
+			steadyStart = AllocationTracker::getThreadCounts();
+		}
+
+		p1Bot.update(match);
+		p2Bot.update(match);
+		match.tick();
+	}
+
+	//A cut off match still played its last rally
+	match.finishStats();
+
+	MatchResult result;
+	result.seed = config.seed;
+	result.winner = match.getWinner();
+	result.ticks = match.getTickCount();
+	result.stats = match.getStats();
+	result.steadyAllocations = isSteady ? (AllocationTracker::getThreadCounts() - steadyStart).allocations : 0;
+	return result;
+}
+
+BatchSummary runBatch(const std::vector<MatchConfig>& configs, int totalThreads)
+{
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+	//Every job writes its own slot, no locking needed
+	std::vector<MatchResult> results(configs.size());
+	{
+		ThreadPool pool(totalThreads);
+		for (size_t i = 0; i < configs.size(); ++i)
+		{
+			pool.submit([&configs, &results, i] { results[i] = runMatch(configs[i]); });
+		}
+		pool.wait();
+	}
+
+	BatchSummary summary = BatchSummary();
+	summary.totalMatches = (int)results.size();
+	for (size_t i = 0; i < results.size(); ++i)
+	{
+		const MatchResult& result = results[i];
+		summary.wins[result.winner] += 1;
+		summary.totalTicks += result.ticks;
+		summary.totalPoints += result.stats.points;
+		summary.cutOffRallies += result.stats.cutOffRallies;
+		summary.totalBarHits += result.stats.barHits;
+		if (result.stats.longestRally > summary.longestRally)
+		{
+			summary.longestRally = result.stats.longestRally;
+		}
+		for (int stage = 0; stage < MAX_TRACKED_STAGES; ++stage)
+		{
+			summary.goalsPerStage[stage] += result.stats.goalsPerStage[stage];
+		}
+		summary.steadyAllocations += result.steadyAllocations;
+		if (result.steadyAllocations > 0)
+		{
+			summary.allocatingMatches += 1;
+		}
+	}
+
+	summary.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	return summary;
+}
+
+void BatchSummary::print()
+{
+	int finished = wins[1] + wins[2];
+	printf("Matches: %d, player 1 wins: %d (%.1f%%), player 2 wins: %d (%.1f%%), unfinished: %d\n",
+		totalMatches,
+		wins[1], finished > 0 ? 100.0 * wins[1] / finished : 0.0,
+		wins[2], finished > 0 ? 100.0 * wins[2] / finished : 0.0,
+		wins[0]);
+	int totalRallies = totalPoints + cutOffRallies;
+	printf("Points: %d, cut off rallies: %d, average rally: %.2f bar hits, longest rally: %d\n",
+		totalPoints, cutOffRallies, totalRallies > 0 ? (double)totalBarHits / totalRallies : 0.0, longestRally);
+
+	printf("Goals per stage:");
+	for (int stage = 0; stage < MAX_TRACKED_STAGES; ++stage)
+	{
+		if (goalsPerStage[stage] > 0)
+		{
+			printf(" %d: %d", stage + 1, goalsPerStage[stage]);
+		}
+	}
+	printf("\n");
+
+	printf("Ticks: %lld in %.3f s (%.0f ticks/s)\n", totalTicks, seconds, seconds > 0 ? totalTicks / seconds : 0.0);
+
+	if (AllocationTracker::isEnabled())
+	{
+		printf("Steady state allocations: %lld in %d matches\n", steadyAllocations, allocatingMatches);
+	}
+}
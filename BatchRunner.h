@@ -0,0 +1,70 @@
+#pragma once
+#include <vector>
+#include "Match.h"
+#include "BotController.h"
+
+//Setup of one simulated match
+struct MatchConfig
+{
+	//Seed of the match's random sequence
+	Uint64 seed;
+
+	BotPolicy p1Policy;
+	BotPolicy p2Policy;
+	SpeedCurve speedCurve;
+
+	//Balls bouncing around besides the one in play, 0 for a normal match
+	int extraBalls;
+
+	//Layout to play on, NULL for the standard arena
+	//Matches share it read only, so one loaded arena serves the whole batch
+	ArenaHandle arena;
+
+	//Matches nobody wins within this many ticks are cut off
+	int maxTicks;
+};
+
+//Outcome of one simulated match
+struct MatchResult
+{
+	Uint64 seed;
+
+	//Winning player, 0 if the match was cut off
+	int winner;
+	int ticks;
+	MatchStats stats;
+
+	//Heap allocations after the first tick, always 0 unless built with TRACK_ALLOCATIONS
+	long long steadyAllocations;
+};
+
+//Totals over a batch of matches
+struct BatchSummary
+{
+	int totalMatches;
+	int wins[3];
+	long long totalTicks;
+	int totalPoints;
+
+	//Rallies of cut off matches, they count towards the average rally but scored no point
+	int cutOffRallies;
+	long long totalBarHits;
+	int longestRally;
+	int goalsPerStage[MAX_TRACKED_STAGES];
+
+	//Steady state heap allocations over all matches, and the matches that made any
+	long long steadyAllocations;
+	int allocatingMatches;
+
+	//Wall clock time the batch took
+	double seconds;
+
+	//Prints the summary
+	void print();
+};
+
+//Runs a single match to the end, safe to call from any thread
+MatchResult runMatch(const MatchConfig& config);
+
+//Runs every configuration on a work stealing pool, 0 threads uses all cores
+BatchSummary runBatch(const std::vector<MatchConfig>& configs, int totalThreads = 0);
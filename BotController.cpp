@@ -0,0 +1,139 @@
+#include "BotController.h"
+#include <algorithm>
+#include <cmath>
+
+BotController::BotController(int init_player, BotPolicy init_policy)
+{
+	player = init_player;
+	policy = init_policy;
+	mMaxSpeed = PBar::BAR_VEL;
+	mBarMode = BAR_MODE_AUTO;
+}
+
+void BotController::setMaxSpeed(int maxSpeed)
+{
+	mMaxSpeed = maxSpeed;
+}
+
+void BotController::setBarMode(BarMode barMode)
+{
+	mBarMode = barMode;
+}
+
+bool BotController::predictDotY(Dot& dot, int dotX, float& dotY)
+{
+	SDL_Rect box = dot.getCollider();
+	int velX = dot.getVelX();
+	if (velX == 0 || (dotX - box.x > 0) != (velX > 0))
+	{
+		return false;
+	}
+
+	//Straight line ignoring the walls
+	float ticks = (float)(dotX - box.x) / velX;
+	float y = box.y + dot.getVelY() * ticks;
+
+	//Unfold the bounces, the path repeats every two crossings of the playfield
+	float minY = (float)PLAYFIELD_TOP;
+	float span = (float)(SCREEN_HEIGHT - Dot::DOT_HEIGHT - PLAYFIELD_TOP);
+	float folded = std::fmod(y - minY, 2.0f * span);
+	if (folded < 0.0f)
+	{
+		folded += 2.0f * span;
+	}
+	if (folded > span)
+	{
+		folded = 2.0f * span - folded;
+	}
+
+	dotY = minY + folded;
+	return true;
+}
+
+BarMode BotController::chooseBarMode(Match& match)
+{
+	//Once the ball got past the front bar, only the goal bar can still save it
+	//The front bar holds still so it doesn't swat the ball back when it returns
+	SDL_Rect dot = match.getDot().getCollider();
+	EntityStore& entities = match.getEntities();
+	for (int i = 0; i < entities.getBarCount(); ++i)
+	{
+		if (entities.barPlayer[i] != player || entities.barId[i] != 2)
+		{
+			continue;
+		}
+
+		int frontX = entities.barX[i];
+		bool isBehind = player == 1 ? dot.x + dot.w <= frontX : dot.x >= frontX + entities.barWidth[i];
+		return isBehind ? BAR_MODE_GOAL_BAR : BAR_MODE_BOTH;
+	}
+	return BAR_MODE_BOTH;
+}
+
+int BotController::getTargetY(Dot& dot, const SDL_Rect& box)
+{
+	SDL_Rect ball = dot.getCollider();
+	int ballCenterY = ball.y + ball.h / 2;
+	if (policy == BOT_POLICY_TRACKING)
+	{
+		return ballCenterY;
+	}
+
+	//Player 1 defends the left side, the bar's face points away from its goal
+	int towardsGoal = player == 1 ? -1 : 1;
+	int velX = dot.getVelX();
+	if (velX == 0)
+	{
+		return ballCenterY;
+	}
+
+	float dotY;
+	if (velX * towardsGoal > 0)
+	{
+		//Meet the ball with the center of the bar
+		int faceX = player == 1 ? box.x + box.w : box.x - ball.w;
+		if (predictDotY(dot, faceX, dotY))
+		{
+			return (int)dotY + ball.h / 2;
+		}
+	}
+	else
+	{
+		//The ball comes from behind, get out of its way so it doesn't bounce back into the goal
+		int backX = player == 1 ? box.x - ball.w : box.x + box.w;
+		if (predictDotY(dot, backX, dotY))
+		{
+			int crossY = (int)dotY + ball.h / 2;
+			int middleY = (PLAYFIELD_TOP + SCREEN_HEIGHT) / 2;
+			return crossY > middleY ? PLAYFIELD_TOP : SCREEN_HEIGHT;
+		}
+	}
+
+	//Nothing to meet, stay level with the ball
+	return ballCenterY;
+}
+
+void BotController::update(Match& match)
+{
+	if (policy == BOT_POLICY_IDLE)
+	{
+		return;
+	}
+
+	match.setBarMode(player, mBarMode == BAR_MODE_AUTO ? chooseBarMode(match) : mBarMode);
+
+	Dot dot = match.getDot();
+	EntityStore& entities = match.getEntities();
+	for (int i = 0; i < entities.getBarCount(); ++i)
+	{
+		if (entities.barPlayer[i] != player)
+		{
+			continue;
+		}
+
+		//Close the distance as far as the speed limit allows
+		SDL_Rect box = { entities.barX[i], entities.barY[i], entities.barWidth[i], entities.barHeight[i] };
+		int offset = getTargetY(dot, box) - (box.y + box.h / 2);
+		entities.barVelY[i] = std::max(-mMaxSpeed, std::min(offset, mMaxSpeed));
+	}
+}
@@ -0,0 +1,51 @@
+#pragma once
+#include "Match.h"
+
+//How a computer player moves its bars
+enum BotPolicy
+{
+	//Bars stay where they are
+	BOT_POLICY_IDLE = 0,
+
+	//Bars follow the ball height
+	BOT_POLICY_TRACKING = 1,
+
+	//Bars head for where the ball will cross them, bouncing off the top wall and the floor
+	BOT_POLICY_PREDICTIVE = 2,
+
+	BOT_POLICY_TOTAL = 3
+};
+
+//Drives one player's bars directly, without key events
+//Decisions are a handful of arithmetic per bar, cheap enough to run every simulated tick
+class BotController
+{
+public:
+	//Initializes the variables
+	BotController(int init_player, BotPolicy init_policy);
+
+	//Limits how fast the bars move, slower bars make an easier opponent
+	void setMaxSpeed(int maxSpeed);
+
+	//Picks a fixed bar mode, or BAR_MODE_AUTO to choose one every decision
+	void setBarMode(BarMode barMode);
+
+	//Sets the bar modes and velocities for the next tick
+	void update(Match& match);
+
+	//Gets the top of the dot when it reaches the given left edge, folding bounces off the top wall and the floor
+	//Returns false if the dot is not heading there
+	static bool predictDotY(Dot& dot, int dotX, float& dotY);
+
+private:
+	//Picks which bars should move for where the ball is
+	BarMode chooseBarMode(Match& match);
+
+	//Gets where the center of a bar with the given box should go
+	int getTargetY(Dot& dot, const SDL_Rect& box);
+
+	int player;
+	BotPolicy policy;
+	int mMaxSpeed;
+	BarMode mBarMode;
+};
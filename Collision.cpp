@@ -0,0 +1,109 @@
+#include "Collision.h"
+
+bool checkCollision(const SDL_Rect& a, const SDL_Rect& b)
+{
+	//The sides of the rectangles
+	int leftA, leftB;
+	int rightA, rightB;
+	int topA, topB;
+	int bottomA, bottomB;
+
+	//Calculate the sides of rect A
+	leftA = a.x;
+	rightA = a.x + a.w;
+	topA = a.y;
+	bottomA = a.y + a.h;
+
+	//Calculate the sides of rect B
+	leftB = b.x;
+	rightB = b.x + b.w;
+	topB = b.y;
+	bottomB = b.y + b.h;
+
+	//If any of the sides from A are outside of B
+	if (bottomA <= topB)
+	{
+		return false;
+	}
+
+	if (topA >= bottomB)
+	{
+		return false;
+	}
+
+	if (rightA <= leftB)
+	{
+		return false;
+	}
+
+	if (leftA >= rightB)
+	{
+		return false;
+	}
+
+	//If none of the sides from A are outside B
+	return true;
+}
+
+//Gets the times at which a moving span enters and leaves a fixed span along one axis
+static bool sweepAxis(float minA, float sizeA, float minB, float sizeB, float vel, float& entry, float& exit)
+{
+	if (vel > 0.f)
+	{
+		entry = (minB - (minA + sizeA)) / vel;
+		exit = (minB + sizeB - minA) / vel;
+	}
+	else if (vel < 0.f)
+	{
+		entry = (minB + sizeB - minA) / vel;
+		exit = (minB - (minA + sizeA)) / vel;
+	}
+	else
+	{
+		//Not moving on this axis, the spans have to overlap for the whole tick
+		if (minA >= minB + sizeB || minA + sizeA <= minB)
+		{
+			return false;
+		}
+		entry = -1e30f;
+		exit = 1e30f;
+	}
+	return true;
+}
+
+bool sweepCollision(const SDL_FRect& a, float velX, float velY, const SDL_FRect& b, float targetVelX, float targetVelY, SweepHit& hit)
+{
+	//Move a relative to b, so b stands still
+	float relVelX = velX - targetVelX;
+	float relVelY = velY - targetVelY;
+
+	float entryX, exitX, entryY, exitY;
+	if (!sweepAxis(a.x, a.w, b.x, b.w, relVelX, entryX, exitX)
+		|| !sweepAxis(a.y, a.h, b.y, b.h, relVelY, entryY, exitY))
+	{
+		return false;
+	}
+
+	//Boxes touch once they overlap on both axes
+	float entry = entryX > entryY ? entryX : entryY;
+	float exit = exitX < exitY ? exitX : exitY;
+
+	//Separated for the whole tick, already overlapping or only grazing an edge
+	if (entry >= exit || entry < 0.f || entry > 1.f)
+	{
+		return false;
+	}
+
+	hit.time = entry;
+	if (entryX > entryY)
+	{
+		hit.normalX = relVelX > 0.f ? -1 : 1;
+		hit.normalY = 0;
+	}
+	else
+	{
+		hit.normalX = 0;
+		hit.normalY = relVelY > 0.f ? -1 : 1;
+	}
+	return true;
+}
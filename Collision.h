@@ -0,0 +1,29 @@
+#pragma once
+#include <SDL.h>
+
+//Solid box that moving boxes bounce off
+struct Obstacle
+{
+	//Box at the start of the tick
+	SDL_Rect box;
+
+	//Distance the box moves during the tick
+	int velX, velY;
+};
+
+//First contact of a moving box
+struct SweepHit
+{
+	//Fraction of the movement done before the contact, from 0 to 1
+	float time;
+
+	//Contact normal, points from the hit box towards the moving box
+	int normalX, normalY;
+};
+
+//Box collision detector
+bool checkCollision(const SDL_Rect& a, const SDL_Rect& b);
+
+//Finds when box a moving by (velX, velY) first touches box b moving by (targetVelX, targetVelY)
+//Boxes that already overlap or move apart don't report a hit
+bool sweepCollision(const SDL_FRect& a, float velX, float velY, const SDL_FRect& b, float targetVelX, float targetVelY, SweepHit& hit);
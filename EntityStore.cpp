@@ -0,0 +1,344 @@
+#include "EntityStore.h"
+#include <stdlib.h>
+#include <cmath>
+#include <algorithm>
+#include "GameObjects.h"
+#include "BallKernel.h"
+
+int ObstacleIndex::query(const SDL_Rect& box, int* items) const
+{
+	//Both lists are ascending and every static number is above every moving one, so together they stay in order
+	int totalMoving = moving->query(box, items);
+	int totalFixed = fixed->query(box, items + totalMoving);
+	int firstFixed = moving->getMaxItems();
+	for (int i = totalMoving; i < totalMoving + totalFixed; ++i)
+	{
+		items[i] += firstFixed;
+	}
+	return totalMoving + totalFixed;
+}
+
+int ObstacleIndex::getMaxItems() const
+{
+	return moving->getMaxItems() + fixed->getItemCount();
+}
+
+int EntityStore::addBall()
+{
+	ballX.push_back(SCREEN_WIDTH / 2);
+	ballY.push_back(SCREEN_HEIGHT / 2);
+	ballPrevX.push_back(SCREEN_WIDTH / 2);
+	ballPrevY.push_back(SCREEN_HEIGHT / 2);
+	ballVelX.push_back(0);
+	ballVelY.push_back(0);
+	ballRolling.push_back(1);
+	return getBallCount() - 1;
+}
+
+int EntityStore::addBar(int player, int id, int x, int y, int width, int height)
+{
+	barX.push_back(x);
+	barY.push_back(y);
+	barPrevX.push_back(x);
+	barPrevY.push_back(y);
+	barVelX.push_back(0);
+	barVelY.push_back(0);
+	barWidth.push_back(width);
+	barHeight.push_back(height);
+	barPlayer.push_back(player);
+	barId.push_back(id);
+	barDisabled.push_back(0);
+	return getBarCount() - 1;
+}
+
+int EntityStore::addWall(int x, int y, int width, int height)
+{
+	wallX.push_back(x);
+	wallY.push_back(y);
+	wallWidth.push_back(width);
+	wallHeight.push_back(height);
+	return getWallCount() - 1;
+}
+
+int EntityStore::addGoal(int player, int x, int y, int width, int height)
+{
+	goalX.push_back(x);
+	goalY.push_back(y);
+	goalWidth.push_back(width);
+	goalHeight.push_back(height);
+	goalPlayer.push_back(player);
+	return getGoalCount() - 1;
+}
+
+void EntityStore::resizeBalls(int totalBalls)
+{
+	while (getBallCount() < totalBalls)
+	{
+		addBall();
+	}
+
+	ballX.resize(totalBalls);
+	ballY.resize(totalBalls);
+	ballPrevX.resize(totalBalls);
+	ballPrevY.resize(totalBalls);
+	ballVelX.resize(totalBalls);
+	ballVelY.resize(totalBalls);
+	ballRolling.resize(totalBalls);
+}
+
+void EntityStore::clear()
+{
+	*this = EntityStore();
+}
+
+int EntityStore::getBallCount() const
+{
+	return (int)ballX.size();
+}
+
+int EntityStore::getBarCount() const
+{
+	return (int)barX.size();
+}
+
+int EntityStore::getWallCount() const
+{
+	return (int)wallX.size();
+}
+
+int EntityStore::getGoalCount() const
+{
+	return (int)goalX.size();
+}
+
+void EntityStore::moveBars()
+{
+	int totalBars = getBarCount();
+	for (int i = 0; i < totalBars; ++i)
+	{
+		barPrevX[i] = barX[i];
+		barPrevY[i] = barY[i];
+		if (barDisabled[i])
+		{
+			continue;
+		}
+
+		//Keep the bar between the top wall and the bottom of the screen
+		barX[i] += barVelX[i];
+		barY[i] = std::max(PLAYFIELD_TOP, std::min(barY[i] + barVelY[i], SCREEN_HEIGHT - barHeight[i]));
+	}
+}
+
+int EntityStore::gatherBarObstacles(Obstacle* obstacles, int maxObstacles) const
+{
+	int totalObstacles = 0;
+	int totalBars = getBarCount();
+	for (int i = 0; i < totalBars && totalObstacles < maxObstacles; ++i)
+	{
+		Obstacle& obstacle = obstacles[totalObstacles++];
+		obstacle.box = { barPrevX[i], barPrevY[i], barWidth[i], barHeight[i] };
+		obstacle.velX = barX[i] - barPrevX[i];
+		obstacle.velY = barY[i] - barPrevY[i];
+	}
+	return totalObstacles;
+}
+
+//Gets an obstacle's bit in a hit mask, obstacles past the first 32 have none
+static Uint32 getHitBit(int obstacle)
+{
+	return obstacle < 32 ? 1u << obstacle : 0;
+}
+
+//Reflects a ball's velocity off an obstacle hit along the given normal, a moving bar hands over its speed
+static void bounceBall(int& velX, int& velY, const Obstacle& obstacle, int normalX, int normalY)
+{
+	int maxVel = Dot::DOT_MAX_VEL;
+	if (normalX != 0)
+	{
+		velX = 2 * obstacle.velX - velX;
+		velX = std::max(-maxVel, std::min(velX, maxVel));
+	}
+	if (normalY != 0)
+	{
+		velY = 2 * obstacle.velY - velY;
+		velY = std::max(-maxVel, std::min(velY, maxVel));
+	}
+}
+
+//Moves a ball out of an obstacle it ended up inside of, returns whether it had to
+static bool pushBallOut(int& posX, int& posY, int& velX, int& velY, const Obstacle& obstacle)
+{
+	//Obstacle at the end of the tick
+	SDL_Rect box = obstacle.box;
+	box.x += obstacle.velX;
+	box.y += obstacle.velY;
+	SDL_Rect ball = { posX, posY, Dot::DOT_WIDTH, Dot::DOT_HEIGHT };
+	if (!checkCollision(ball, box))
+	{
+		return false;
+	}
+
+	//Leave through the side with the least overlap
+	int pushLeft = ball.x + ball.w - box.x;
+	int pushRight = box.x + box.w - ball.x;
+	int pushUp = ball.y + ball.h - box.y;
+	int pushDown = box.y + box.h - ball.y;
+	int pushX = pushLeft < pushRight ? -pushLeft : pushRight;
+	int pushY = pushUp < pushDown ? -pushUp : pushDown;
+
+	if (std::abs(pushX) < std::abs(pushY))
+	{
+		posX += pushX;
+		if ((velX - obstacle.velX) * pushX < 0)
+		{
+			bounceBall(velX, velY, obstacle, pushX > 0 ? 1 : -1, 0);
+		}
+	}
+	else
+	{
+		posY += pushY;
+		if ((velY - obstacle.velY) * pushY < 0)
+		{
+			bounceBall(velX, velY, obstacle, 0, pushY > 0 ? 1 : -1);
+		}
+	}
+	return true;
+}
+
+//Pushes a ball out of the candidate obstacles in index order, returns a mask of the ones it was inside of
+//The candidates have to be all obstacles near the ball, they're looked up again whenever a push moves it
+static Uint32 pushBallOutOfObstacles(int& posX, int& posY, int& velX, int& velY, const Obstacle* obstacles, const ObstacleIndex& index, int* candidates, int totalCandidates)
+{
+	Uint32 hitMask = 0;
+	for (int c = 0; c < totalCandidates; ++c)
+	{
+		int obstacle = candidates[c];
+		if (!pushBallOut(posX, posY, velX, velY, obstacles[obstacle]))
+		{
+			continue;
+		}
+		hitMask |= getHitBit(obstacle);
+
+		//The ball moved, look again around where it is now for the obstacles after this one
+		SDL_Rect ball = { posX, posY, Dot::DOT_WIDTH, Dot::DOT_HEIGHT };
+		totalCandidates = index.query(ball, candidates);
+		c = (int)(std::upper_bound(candidates, candidates + totalCandidates, obstacle) - candidates) - 1;
+	}
+	return hitMask;
+}
+
+void EntityStore::moveBalls(int totalBalls, const Obstacle* obstacles, const ObstacleIndex& index, int* candidates, Uint32* hitMasks)
+{
+	for (int ball = 0; ball < totalBalls; ++ball)
+	{
+		ballPrevX[ball] = ballX[ball];
+		ballPrevY[ball] = ballY[ball];
+		hitMasks[ball] = 0;
+		if (!ballRolling[ball])
+		{
+			continue;
+		}
+
+		//Sweep the ball along its path, bouncing at each first contact
+		int velX = ballVelX[ball];
+		int velY = ballVelY[ball];
+		float posX = (float)ballX[ball];
+		float posY = (float)ballY[ball];
+		float elapsed = 0.f;
+		Uint32 hitMask = 0;
+
+		//Nothing moves further than the top speed in a tick, whatever it bounces off on the way
+		int reach = Dot::DOT_MAX_VEL + 1;
+		SDL_Rect reachBox = { ballX[ball] - reach, ballY[ball] - reach, Dot::DOT_WIDTH + 2 * reach, Dot::DOT_HEIGHT + 2 * reach };
+		int totalCandidates = index.query(reachBox, candidates);
+
+		for (int hits = 0; hits < Dot::MAX_HITS_PER_TICK && elapsed < 1.f; ++hits)
+		{
+			float remaining = 1.f - elapsed;
+			SDL_FRect box = { posX, posY, (float)Dot::DOT_WIDTH, (float)Dot::DOT_HEIGHT };
+
+			//Find the earliest contact over the rest of the tick
+			SweepHit firstHit = { 1.f, 0, 0 };
+			int firstObstacle = -1;
+			for (int c = 0; c < totalCandidates; ++c)
+			{
+				int i = candidates[c];
+				const Obstacle& obstacle = obstacles[i];
+				SDL_FRect obstacleBox = {
+					obstacle.box.x + obstacle.velX * elapsed,
+					obstacle.box.y + obstacle.velY * elapsed,
+					(float)obstacle.box.w,
+					(float)obstacle.box.h
+				};
+
+				SweepHit hit;
+				if (sweepCollision(box, velX * remaining, velY * remaining, obstacleBox, obstacle.velX * remaining, obstacle.velY * remaining, hit)
+					&& (firstObstacle < 0 || hit.time < firstHit.time))
+				{
+					firstHit = hit;
+					firstObstacle = i;
+				}
+			}
+
+			//Move up to the contact, or to the end of the tick if nothing is hit
+			posX += velX * remaining * firstHit.time;
+			posY += velY * remaining * firstHit.time;
+			elapsed += remaining * firstHit.time;
+
+			if (firstObstacle < 0)
+			{
+				break;
+			}
+			bounceBall(velX, velY, obstacles[firstObstacle], firstHit.normalX, firstHit.normalY);
+			hitMask |= getHitBit(firstObstacle);
+		}
+
+		int endX = (int)std::lround(posX);
+		int endY = (int)std::lround(posY);
+
+		//Rounding or a bar moving onto the ball can leave it slightly inside, it's still within reach of the start
+		hitMask |= pushBallOutOfObstacles(endX, endY, velX, velY, obstacles, index, candidates, totalCandidates);
+
+		ballX[ball] = endX;
+		ballY[ball] = endY;
+		ballVelX[ball] = velX;
+		ballVelY[ball] = velY;
+		hitMasks[ball] = hitMask;
+	}
+}
+
+void EntityStore::moveFreeBalls(int firstBall, const Obstacle* obstacles, const ObstacleIndex& index, int* candidates)
+{
+	int totalBalls = getBallCount() - firstBall;
+	if (totalBalls <= 0)
+	{
+		return;
+	}
+
+	BallBounds bounds = { 0, PLAYFIELD_TOP, SCREEN_WIDTH - Dot::DOT_WIDTH, SCREEN_HEIGHT - Dot::DOT_HEIGHT };
+	stepBalls(&ballX[firstBall], &ballY[firstBall], &ballPrevX[firstBall], &ballPrevY[firstBall],
+		&ballVelX[firstBall], &ballVelY[firstBall], totalBalls, bounds);
+
+	int endBall = firstBall + totalBalls;
+	for (int ball = firstBall; ball < endBall; ++ball)
+	{
+		SDL_Rect box = { ballX[ball], ballY[ball], Dot::DOT_WIDTH, Dot::DOT_HEIGHT };
+		int totalCandidates = index.query(box, candidates);
+		pushBallOutOfObstacles(ballX[ball], ballY[ball], ballVelX[ball], ballVelY[ball], obstacles, index, candidates, totalCandidates);
+	}
+}
+
+int EntityStore::findGoal(int ball) const
+{
+	SDL_Rect box = { ballX[ball], ballY[ball], Dot::DOT_WIDTH, Dot::DOT_HEIGHT };
+	int totalGoals = getGoalCount();
+	for (int i = 0; i < totalGoals; ++i)
+	{
+		SDL_Rect goal = { goalX[i], goalY[i], goalWidth[i], goalHeight[i] };
+		if (checkCollision(box, goal))
+		{
+			return i;
+		}
+	}
+	return -1;
+}
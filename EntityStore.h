@@ -0,0 +1,104 @@
+#pragma once
+#include <SDL.h>
+#include <vector>
+#include "Collision.h"
+#include "SpatialGrid.h"
+
+//Finds the obstacles near a box
+//Obstacles are numbered moving ones first, then static ones, so the static grid's items are offset by the moving grid's size
+struct ObstacleIndex
+{
+	//Moving obstacles, updated every tick
+	SpatialGrid* moving;
+
+	//Obstacles that never move, shared read only
+	const StaticGrid* fixed;
+
+	//Writes the obstacles near the box in ascending order, returns how many
+	int query(const SDL_Rect& box, int* items) const;
+
+	//Gets the total number of obstacles
+	int getMaxItems() const;
+};
+
+//Every box of a match, stored as a structure of arrays
+//Each field of a kind of entity has its own contiguous array, so the update and collision passes are tight loops over them
+//Game logic and rendering reach single entities through handles like Dot and PBar, which only hold an index
+struct EntityStore
+{
+	//Balls, all of them DOT_WIDTH by DOT_HEIGHT
+	//The previous position is where the ball started the last tick
+	std::vector<int> ballX;
+	std::vector<int> ballY;
+	std::vector<int> ballPrevX;
+	std::vector<int> ballPrevY;
+	std::vector<int> ballVelX;
+	std::vector<int> ballVelY;
+
+	//Whether the ball moves, it's held during the countdown
+	std::vector<Uint8> ballRolling;
+
+	//Bars, a player's bar 1 guards the goal and bar 2 is the tall one in front
+	std::vector<int> barX;
+	std::vector<int> barY;
+	std::vector<int> barPrevX;
+	std::vector<int> barPrevY;
+	std::vector<int> barVelX;
+	std::vector<int> barVelY;
+	std::vector<int> barWidth;
+	std::vector<int> barHeight;
+	std::vector<int> barPlayer;
+	std::vector<int> barId;
+	std::vector<Uint8> barDisabled;
+
+	//Walls, fixed boxes the balls bounce off
+	std::vector<int> wallX;
+	std::vector<int> wallY;
+	std::vector<int> wallWidth;
+	std::vector<int> wallHeight;
+
+	//Goals, a ball inside one scores for the other player
+	std::vector<int> goalX;
+	std::vector<int> goalY;
+	std::vector<int> goalWidth;
+	std::vector<int> goalHeight;
+	std::vector<int> goalPlayer;
+
+	//Adds an entity and returns its index, balls start held in the center
+	int addBall();
+	int addBar(int player, int id, int x, int y, int width, int height);
+	int addWall(int x, int y, int width, int height);
+	int addGoal(int player, int x, int y, int width, int height);
+
+	//Adds or removes balls from the end until there are the given number
+	void resizeBalls(int totalBalls);
+
+	//Removes every entity
+	void clear();
+
+	//Gets entity counts
+	int getBallCount() const;
+	int getBarCount() const;
+	int getWallCount() const;
+	int getGoalCount() const;
+
+	//Moves every enabled bar by its velocity and keeps it inside the playfield
+	void moveBars();
+
+	//Writes the bars as they moved during the last tick, walls don't change so they're written once elsewhere
+	//Returns the number of obstacles written
+	int gatherBarObstacles(Obstacle* obstacles, int maxObstacles) const;
+
+	//Sweeps the first totalBalls rolling balls through the obstacles, bouncing at each contact
+	//Only the obstacles the index finds near a ball are tested against it
+	//candidates is scratch space for the index's maximum item count
+	//Each ball gets a mask of the obstacles it hit, one bit for each of the first 32 obstacles
+	void moveBalls(int totalBalls, const Obstacle* obstacles, const ObstacleIndex& index, int* candidates, Uint32* hitMasks);
+
+	//Moves the balls from firstBall on with the vectorized ball kernel, then pushes them out of obstacles
+	//They always roll and only bounce off the playfield edges and the obstacles they end up inside of
+	void moveFreeBalls(int firstBall, const Obstacle* obstacles, const ObstacleIndex& index, int* candidates);
+
+	//Finds the goal a ball is inside of, -1 if none
+	int findGoal(int ball) const;
+};
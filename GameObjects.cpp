@@ -0,0 +1,229 @@
+#include "GameObjects.h"
+#include <cmath>
+
+Dot::Dot(EntityStore& store, int index)
+{
+	mStore = &store;
+	mIndex = index;
+}
+
+void Dot::reset(int velX, int velY)
+{
+	//Initialize the offsets
+	mStore->ballX[mIndex] = SCREEN_WIDTH / 2;
+	mStore->ballY[mIndex] = SCREEN_HEIGHT / 2;
+	mStore->ballPrevX[mIndex] = SCREEN_WIDTH / 2;
+	mStore->ballPrevY[mIndex] = SCREEN_HEIGHT / 2;
+
+	//Initialize the velocity
+	mStore->ballVelX[mIndex] = velX;
+	mStore->ballVelY[mIndex] = velY;
+}
+
+void Dot::setIsRooling(bool dotState)
+{
+	mStore->ballRolling[mIndex] = dotState ? 1 : 0;
+}
+
+SDL_Rect Dot::getRenderBox(float alpha)
+{
+	int prevX = mStore->ballPrevX[mIndex];
+	int prevY = mStore->ballPrevY[mIndex];
+	SDL_Rect box = getCollider();
+	box.x = (int)std::lround(prevX + (box.x - prevX) * alpha);
+	box.y = (int)std::lround(prevY + (box.y - prevY) * alpha);
+	return box;
+}
+
+SDL_Rect Dot::getCollider()
+{
+	SDL_Rect box = { mStore->ballX[mIndex], mStore->ballY[mIndex], DOT_WIDTH, DOT_HEIGHT };
+	return box;
+}
+
+int Dot::getVelX()
+{
+	return mStore->ballVelX[mIndex];
+}
+
+int Dot::getVelY()
+{
+	return mStore->ballVelY[mIndex];
+}
+
+PBar::PBar(EntityStore& store, int index)
+{
+	mStore = &store;
+	mIndex = index;
+}
+
+void PBar::handleEvent(SDL_Event& e)
+{
+	//Work on copies of the bar's fields, written back at the end
+	int player = getPlayer();
+	int barId = getBarId();
+	bool isDisable = isDisabled();
+	int velY = mStore->barVelY[mIndex];
+
+	//If a key was pressed
+	if (e.type == SDL_KEYDOWN)
+	{
+		switch (e.key.keysym.sym)
+		{
+			case SDLK_1: 
+				if (player == 1 && barId == 1) {
+					isDisable = false;
+				} else if (player == 1 && barId == 2) {
+					isDisable = true;
+				}
+				break;
+			case SDLK_2:
+				if (player == 1 && barId == 1) {
+					isDisable = true;
+				}
+				else if (player == 1 && barId == 2) {
+					isDisable = false;
+				}
+				break;
+			case SDLK_3:
+				if (player == 1 && barId == 1) {
+					isDisable = false;
+				}
+				else if (player == 1 && barId == 2) {
+					isDisable = false;
+				}
+				break;
+			case SDLK_8:
+				if (player == 2 && barId == 1) {
+					isDisable = false;
+				}
+				else if (player == 2 && barId == 2) {
+					isDisable = true;
+				}
+				break;
+			case SDLK_9:
+				if (player == 2 && barId == 1) {
+					isDisable = true;
+				}
+				else if (player == 2 && barId == 2) {
+					isDisable = false;
+				}
+				break;
+			case SDLK_0:
+				if (player == 2 && barId == 1) {
+					isDisable = false;
+				}
+				else if (player == 2 && barId == 2) {
+					isDisable = false;
+				}
+				break;
+		}
+	}
+	//If a key was pressed
+	if (e.type == SDL_KEYDOWN && e.key.repeat == 0)
+	{
+		if (player == 1) {
+			//Adjust the velocity
+			switch (e.key.keysym.sym)
+			{
+				case SDLK_w: velY -= BAR_VEL; break;
+				case SDLK_s: velY += BAR_VEL; break;
+				//case SDLK_LEFT: mVelX -= BAR_VEL; break;
+				//case SDLK_RIGHT: mVelX += BAR_VEL; break;
+			}
+		}
+		else {
+			//Adjust the velocity
+			switch (e.key.keysym.sym)
+			{
+				case SDLK_UP: velY -= BAR_VEL; break;
+				case SDLK_DOWN: velY += BAR_VEL; break;
+				//case SDLK_LEFT: mVelX -= BAR_VEL; break;
+				//case SDLK_RIGHT: mVelX += BAR_VEL; break;
+			}
+		}
+	}
+	//If a key was released
+	else if (e.type == SDL_KEYUP && e.key.repeat == 0)
+	{
+		if (player == 1) {
+			//Adjust the velocity
+			switch (e.key.keysym.sym)
+			{
+				case SDLK_w: velY += BAR_VEL; break;
+				case SDLK_s: velY -= BAR_VEL; break;
+				//case SDLK_LEFT: mVelX -= BAR_VEL; break;
+				//case SDLK_RIGHT: mVelX += BAR_VEL; break;
+			}
+		}
+		else {
+			//Adjust the velocity
+			switch (e.key.keysym.sym)
+			{
+				case SDLK_UP: velY += BAR_VEL; break;
+				case SDLK_DOWN: velY -= BAR_VEL; break;
+				//case SDLK_LEFT: mVelX -= BAR_VEL; break;
+				//case SDLK_RIGHT: mVelX += BAR_VEL; break;
+			}
+		}
+	}
+
+	mStore->barDisabled[mIndex] = isDisable ? 1 : 0;
+	mStore->barVelY[mIndex] = velY;
+}
+
+void PBar::setPos(int new_mPosX, int new_mPosY) {
+	mStore->barX[mIndex] = new_mPosX;
+	mStore->barY[mIndex] = new_mPosY;
+
+	//Teleport, nothing to interpolate from
+	mStore->barPrevX[mIndex] = new_mPosX;
+	mStore->barPrevY[mIndex] = new_mPosY;
+}
+
+void PBar::reset()
+{
+	mStore->barVelX[mIndex] = 0;
+	mStore->barVelY[mIndex] = 0;
+}
+
+SDL_Rect PBar::getRenderBox(float alpha)
+{
+	int prevX = mStore->barPrevX[mIndex];
+	int prevY = mStore->barPrevY[mIndex];
+	SDL_Rect box = getCollider();
+	box.x = (int)std::lround(prevX + (box.x - prevX) * alpha);
+	box.y = (int)std::lround(prevY + (box.y - prevY) * alpha);
+	return box;
+}
+
+bool PBar::isDisabled()
+{
+	return mStore->barDisabled[mIndex] != 0;
+}
+
+SDL_Rect PBar::getCollider()
+{
+	SDL_Rect box = { mStore->barX[mIndex], mStore->barY[mIndex], mStore->barWidth[mIndex], mStore->barHeight[mIndex] };
+	return box;
+}
+
+int PBar::getPlayer()
+{
+	return mStore->barPlayer[mIndex];
+}
+
+int PBar::getBarId()
+{
+	return mStore->barId[mIndex];
+}
+
+void PBar::setVelocity(int velY)
+{
+	mStore->barVelY[mIndex] = velY;
+}
+
+void PBar::setDisabled(bool disabled)
+{
+	mStore->barDisabled[mIndex] = disabled ? 1 : 0;
+}
@@ -0,0 +1,91 @@
+#pragma once
+#include <SDL.h>
+#include "Collision.h"
+#include "EntityStore.h"
+
+//Screen dimension constants
+const int SCREEN_WIDTH = 1280;
+const int SCREEN_HEIGHT = 720;
+
+//Top of the playfield, everything above belongs to the top wall
+const int PLAYFIELD_TOP = 100;
+
+//The dimensions of a goal
+const int GOAL_WIDTH = 40;
+const int GOAL_HEIGHT = 300;
+
+//The dot that will move around on the screen
+//A handle to a ball of an entity store, cheap to copy, valid while the store keeps its balls
+class Dot
+{
+public:
+	//The dimensions of the dot
+	static const int DOT_WIDTH = 20;
+	static const int DOT_HEIGHT = 20;
+
+	//Fastest the dot can go after being hit by a moving bar
+	static const int DOT_MAX_VEL = 40;
+
+	//Most bounces resolved within one tick
+	static const int MAX_HITS_PER_TICK = 4;
+
+	//Points the handle at a ball of the store
+	Dot(EntityStore& store, int index);
+
+	//Serves the dot from the center with the given velocity
+	void reset(int velX, int velY);
+
+	//Holds or releases the dot
+	void setIsRooling(bool dotState);
+
+	//Gets where to show the dot, interpolated between the last two ticks
+	SDL_Rect getRenderBox(float alpha);
+
+	//Gets dot state
+	SDL_Rect getCollider();
+	int getVelX();
+	int getVelY();
+
+private:
+	EntityStore* mStore;
+	int mIndex;
+};
+
+//A handle to a bar of an entity store, cheap to copy, valid while the store keeps its bars
+class PBar
+{
+public:
+	//Maximum axis velocity of the bar
+	static const int BAR_VEL = 20;
+
+	//The dimensions of one paddle, the front bar is two paddles tall
+	static const int BAR_WIDTH = 24;
+	static const int BAR_HEIGHT = 104;
+
+	//Points the handle at a bar of the store
+	PBar(EntityStore& store, int index);
+
+	//Takes key presses and adjusts the bar's velocity
+	void handleEvent(SDL_Event& e);
+
+	//Teleports the bar
+	void setPos(int new_mPosX, int new_mPosY);
+	void reset();
+
+	//Drives the bar directly, without key events
+	void setVelocity(int velY);
+	void setDisabled(bool disabled);
+
+	//Gets where to show the bar, interpolated between the last two ticks
+	SDL_Rect getRenderBox(float alpha);
+	bool isDisabled();
+
+	//Gets bar state
+	SDL_Rect getCollider();
+	int getPlayer();
+	int getBarId();
+
+private:
+	EntityStore* mStore;
+	int mIndex;
+};
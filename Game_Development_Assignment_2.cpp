@@ -6,20 +6,81 @@ and may not be redistributed without written permission.*/
 #include <SDL_image.h>
 #include <SDL_ttf.h>
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 #include <string>
 #include <sstream>
 #include <cmath>
+#include <algorithm>
+#include <vector>
 #include <time.h>
 #include "LTimer.h"
+#include "LTexture.h"
+#include "AssetManager.h"
+#include "GlyphAtlas.h"
+#include "HudText.h"
+#include "Match.h"
+#include "BotController.h"
+#include "Profiler.h"
+#include "AllocationTracker.h"
+#include "TraceRecorder.h"
+#include "RenderLayer.h"
+#include "SpriteBatch.h"
+#include "Replay.h"
+#include "Rollback.h"
+#include "NetTransport.h"
 
-//Screen dimension constants
-const int SCREEN_WIDTH = 1280;
-const int SCREEN_HEIGHT = 720;
+//Bar speed of the Bot Mode opponent, a bit slower than a player's so it can be beaten
+const int BOT_MODE_BAR_SPEED = PBar::BAR_VEL * 3 / 4;
+
+//Balls bouncing around besides the one in play in Multiball Mode
+const int MULTIBALL_EXTRA_BALLS = 1000;
+
+//Packed assets built by Asset_Packer, loose files are used when it's missing
+const char* ASSET_ARCHIVE_PATH = "assets.pak";
+
+//Images packed into the scene atlas, and the font
+const std::vector<std::string> SCENE_IMAGE_PATHS = { "image/ball.png", "image/paddleBlu.png", "image/paddleRed.png", "image/groundGrass_mown1.png" };
+const char* FONT_PATH = "font/Cartos.ttf";
+
+//Layout the matches are played on, the built in standard arena is used when it can't be loaded
+const char* ARENA_PATH = "arena/standard.txt";
+
+//Every match played is recorded here, replacing the last one
+const char* REPLAY_PATH = "replay.ppr";
+
+//Seed of the first netplay match, both peers count up from it so they play the same serves
+const Uint64 NETPLAY_SEED = 0x5EED;
+
+//Longest an idle menu sleeps before checking on itself
+const Uint32 MENU_IDLE_TIMEOUT_MS = 500;
+
+//Loading screen progress bar size
+const int LOADING_BAR_WIDTH = 400;
+const int LOADING_BAR_HEIGHT = 24;
+
+//Where F4 writes the Chrome trace
+const char* TRACE_FILE_PATH = "trace.json";
+
+//Longest frame the simulation catches up on, anything beyond is dropped
+const double MAX_FRAME_SECONDS = 0.25;
 
 //Button constants
 const int BUTTON_WIDTH = 125;
 const int BUTTON_HEIGHT = 50;
-const int TOTAL_BUTTONS = 4;
+const int TOTAL_BUTTONS = 5;
+
+enum GameMode
+{
+	GAME_MODE_STANDARD = 0,
+	GAME_MODE_EXPERT = 1,
+
+	//Player 2 is played by the computer
+	GAME_MODE_BOT = 2,
+
+	//Standard rules with a swarm of extra balls on the field
+	GAME_MODE_MULTIBALL = 3
+};
 
 enum LButtonSprite
 {
@@ -30,48 +91,13 @@ enum LButtonSprite
 	BUTTON_SPRITE_TOTAL = 4
 };
 
-//Texture wrapper class
-class LTexture
+//Text color of each button sprite
+const SDL_Color BUTTON_SPRITE_COLORS[BUTTON_SPRITE_TOTAL] =
 {
-public:
-	//Initializes variables
-	LTexture();
-
-	//Deallocates memory
-	~LTexture();
-
-	//Loads image at specified path
-	bool loadFromFile(std::string path);
-
-	//Creates image from font string
-	bool loadFromRenderedText(std::string textureText, SDL_Color textColor);
-
-	//Deallocates texture
-	void free();
-
-	//Set color modulation
-	void setColor(Uint8 red, Uint8 green, Uint8 blue);
-
-	//Set blending
-	void setBlendMode(SDL_BlendMode blending);
-
-	//Set alpha modulation
-	void setAlpha(Uint8 alpha);
-
-	//Renders texture at given point
-	void render(int x, int y, SDL_Rect* clip = NULL, double angle = 0.0, SDL_Point* center = NULL, SDL_RendererFlip flip = SDL_FLIP_NONE);
-
-	//Gets image dimensions
-	int getWidth();
-	int getHeight();
-
-private:
-	//The actual hardware texture
-	SDL_Texture* mTexture;
-
-	//Image dimensions
-	int mWidth;
-	int mHeight;
+	{ 0, 0, 0, 255 },
+	{ 255, 0, 0, 255 },
+	{ 0, 255, 0, 255 },
+	{ 0, 0, 255, 255 }
 };
 
 //The mouse button
@@ -85,6 +111,7 @@ public:
 	void setPosition(int x, int y);
 	void setText(std::string nextButtonText);
 	void setScreenToSwitch(int screenNewId);
+	void setGameModeToSwitch(GameMode gameNewMode);
 
 	//Handles mouse event
 	void handleEvent(SDL_Event* e);
@@ -93,182 +120,35 @@ public:
 	//Shows button sprite
 	void render();
 
+	//Checks whether the sprite changed since the last render
+	bool isDirty();
+
 private:
 	//Top left position
 	SDL_Point mPosition;
-	LTexture gButtonTextTexture;
+
+	//Button dimensions
+	int mWidth;
+	int mHeight;
 
 	//Currently used global sprite
 	LButtonSprite mCurrentSprite;
-	std::stringstream buttonText;
-
-	int screenToSwitch = 2;
-};
-
-class ScoreCounter
-{
-public:
-	//Initializes variables
-	ScoreCounter();
-
-	//actions
-	void reset();
-	void plusScore(int pId);
-	int	getHigherScorePlayer();
-	int getVictoryPlayer();
-	int getStage();
-
-	//render
-	void render();
-
-private:
-	//The clock time when the timer started
-	LTexture gWinnerTexture;
-	int p1Score, p2Score;
-};
-
-//The dot that will move around on the screen
-class Dot
-{
-public:
-	//The dimensions of the dot
-	static const int DOT_WIDTH = 20;
-	static const int DOT_HEIGHT = 20;
 
-	//Maximum axis velocity of the dot
-	static const int DOT_VEL = 5;
+	//Sprite changed since the last render
+	bool mDirty;
 
-	//Initializes the variables
-	Dot();
+	//Renders the text once per sprite into the sprite sheet
+	void buildSprites();
 
-	//Takes key presses and adjusts the dot's velocity
-	void handleEvent(SDL_Event& e);
-
-	//Moves the dot and checks collision
-	void reset();
-	void move();
-
-	//checks collision
-	bool collide(SDL_Rect& wall);
-	void isOutsideMap();
-	bool isCollideGoal(SDL_Rect& wall);
-	void setIsRooling(bool dotState);
-
-	//Shows the dot on the screen
-	void render();
-
-private:
-	//The X and Y offsets of the dot
-	int mPosX, mPosY;
-	bool isRooling = true;
-
-	//The velocity of the dot
-	int mVelX, mVelY;
-
-	//Dot's collision box
-	SDL_Rect mCollider;
-};
-
-class PBar
-{
-public:
-	//Maximum axis velocity of the dot
-	static const int BAR_VEL = 20;
-
-	//Initializes the variables
-	PBar(int init_player, int init_barId, int init_mPosX, int init_mPosY);
-
-	//Takes key presses and adjusts the bar's velocity
-	void handleEvent(SDL_Event& e);
-
-	//Moves the bar
-	void move();
-	void setPos(int new_mPosX, int new_mPosY);
-	void reset();
-
-	//Checks Collision with dot and 4 edge
-	void collide(Dot& dot);
-
-	//Shows the bar on the screen
-	void render();
-
-private:
-	//The dimensions of the bar
-	int BAR_WIDTH = 40;
-	int BAR_HEIGHT = 100;
-
-	//Player
-	int player;
-	int barId;
-
-	//The X and Y offsets of the bar
-	int mPosX, mPosY;
-
-	//The velocity of the bar
-	int mVelX, mVelY;
-
-	//Bar's collision box
-	SDL_Rect mCollider;
-	LTexture onBarTexture;
-	LTexture offBarTexture;
-
-	//is Disable
-	bool isDisable = false;
-};
-
-class Goal
-{
-public:
-	//The dimensions of the bar
-	static const int GOAL_WIDTH = 40;
-	static const int GOAL_HEIGHT = 300;
-
-	//Initializes the variables
-	Goal(int init_player, int init_mPosX, int init_mPosY);
-
-	//Checks Collision with dot and 4 edge
-	bool collide(Dot& dot, ScoreCounter& scoreCounter);
-
-	//Shows the bar on the screen
-	void render();
-
-private:
-	//Player
-	int player;
-
-	//The X and Y offsets of the bar
-	int mPosX, mPosY;
-
-	//Bar's collision box
-	SDL_Rect mCollider;
-};
-
-class Wall
-{
-public:
-	//The dimensions of the bar
-	//static const int WALL_WIDTH = 40;
-	//static const int WALL_HEIGHT = 300;
-
-	//Initializes the variables
-	Wall(int init_width, int init_height, int init_mPosX, int init_mPosY);
-
-	//Checks Collision with dot and 4 edge
-	void collide(Dot& dot);
-
-	//Shows the bar on the screen
-	void render();
-
-private:
-	//The dimensions of the bar
-	int WALL_WIDTH;
-	int WALL_HEIGHT;
+	//Text in every sprite color, stacked top to bottom
+	LTexture mSpriteSheet;
+	SDL_Rect mSpriteClips[BUTTON_SPRITE_TOTAL];
+	std::stringstream buttonText;
 
-	//The X and Y offsets of the bar
-	int mPosX, mPosY;
+	int screenToSwitch = 2;
 
-	//Bar's collision box
-	SDL_Rect mCollider;
+	//Game mode picked by pressing, none if negative
+	int gameModeToSwitch = -1;
 };
 
 class MainMenu {
@@ -277,11 +157,15 @@ public:
 	void render();
 	void handleEvent(SDL_Event* e);
 
+	//Checks whether a shown button changed since the last render
+	bool isDirty();
+
 private:
 	LTexture gTitleTexture;
 	LButton gStartButton;
 	LButton gAdvanceButton;
 	LButton gBotButton;
+	LButton gMultiballButton;
 	LButton gExitButton;
 };
 
@@ -291,6 +175,9 @@ public:
 	void render();
 	void handleEvent(SDL_Event* e);
 
+	//Checks whether a button changed since the last render
+	bool isDirty();
+
 private:
 	LTexture gTitleTexture;
 	LButton gRestartButton;
@@ -303,214 +190,163 @@ bool init();
 //Loads media
 bool loadMedia();
 
-void resetGame(ScoreCounter* scorecounter);
+//Shows a progress bar until the assets are decoded, returns false if the user quit
+bool runLoadingScreen();
+
+//Checks whether an event changes what a menu shows, apart from its buttons
+bool needsMenuRedraw(const SDL_Event& e);
+
+//Renders the static part of the playfield, the background, goals and wall
+void renderPlayfield(Match& match);
+
+//Renders the moving part of a match, interpolated between its last two ticks
+void renderMatch(Match& match, float alpha);
+
+//Renders the score with its top at given height
+void renderScore(ScoreCounter& scoreCounter, int y);
+
+//Renders the frame time graph and percentiles of the profiler
+void renderProfiler(Profiler& profiler);
+
+//Handles the events every screen reacts to, profiling keys and renderer resets
+void handleGlobalEvents(SDL_Event& e);
 
 //Frees media and shuts down SDL
 void close();
 
-//Box collision detector
-bool checkCollision(SDL_Rect a, SDL_Rect b);
+#ifdef TRACK_ALLOCATIONS
+//Wraps SDL's allocator so SDL_malloc and SDL_free are counted too, call before anything else touches SDL
+void hookSdlAllocator();
+#endif
 
 //Screen Id
 int screenId = 1;
 
+//Mode of the next game
+GameMode gameMode = GAME_MODE_STANDARD;
+
 //The window we'll be rendering to
 SDL_Window* gWindow = NULL;
 
 //The window renderer
 SDL_Renderer* gRenderer = NULL;
 
+//Shared textures
+AssetManager gAssets;
+
 //Scene textures
-LTexture gDotTexture;
+TextureHandle gDotTexture;
+TextureHandle gBarOnTexture;
+TextureHandle gBarOffTexture;
+
+//Arena every match is played on
+ArenaHandle gArena;
 
 //Globally used font
 TTF_Font* gFont = NULL;
 
-//Rendered texture
-LTexture gTextTexture;
+//Glyphs of the global font, used for all dynamic text
+GlyphAtlas gTextAtlas;
+
+//Score shown in game and on the result screen
+HudText gScoreText("", " : ");
+
+//Times the phases of every frame, F3 shows it in game
+Profiler gProfiler;
 
-//Rendered Time texture
+//Rendered texture
 LTexture gPromptTextTexture;
-LTexture gTimeTextTexture;
-LTexture gNewStateCountdownTextTexture;
-LTexture gFPSTextTexture;
-LTexture gBackGroundTexture;
+TextureHandle gBackGroundTexture;
+
+//Background, goals and wall, drawn once and reused every frame
+RenderLayer gPlayfieldLayer;
 
-ScoreCounter scoreCounter;
+//Bars and dot, drawn with one call per texture
+SpriteBatch gSpriteBatch;
 
-LTexture::LTexture()
+LButton::LButton(std::string init_button_text, int init_xPos, int init_yPos)
 {
-	//Initialize
-	mTexture = NULL;
-	mWidth = 0;
-	mHeight = 0;
+	mPosition.x = init_xPos;
+	mPosition.y = init_yPos;
+
+	mCurrentSprite = BUTTON_SPRITE_MOUSE_OUT;
+	mDirty = true;
+
+	buttonText.str(init_button_text);
+	buildSprites();
 }
 
-LTexture::~LTexture()
+void LButton::setPosition(int x, int y)
 {
-	//Deallocate
-	free();
+	mPosition.x = x;
+	mPosition.y = y;
 }
 
-bool LTexture::loadFromFile(std::string path)
+void LButton::setText(std::string nextButtonText)
 {
-	//Get rid of preexisting texture
-	free();
-
-	//The final texture
-	SDL_Texture* newTexture = NULL;
-
-	//Load image at specified path
-	SDL_Surface* loadedSurface = IMG_Load(path.c_str());
-	if (loadedSurface == NULL)
-	{
-		printf("Unable to load image %s! SDL_image Error: %s\n", path.c_str(), IMG_GetError());
-	}
-	else
-	{
-		//Color key image
-		SDL_SetColorKey(loadedSurface, SDL_TRUE, SDL_MapRGB(loadedSurface->format, 0, 0xFF, 0xFF));
-
-		//Create texture from surface pixels
-		newTexture = SDL_CreateTextureFromSurface(gRenderer, loadedSurface);
-		if (newTexture == NULL)
-		{
-			printf("Unable to create texture from %s! SDL Error: %s\n", path.c_str(), SDL_GetError());
-		}
-		else
-		{
-			//Get image dimensions
-			mWidth = loadedSurface->w;
-			mHeight = loadedSurface->h;
-		}
-
-		//Get rid of old loaded surface
-		SDL_FreeSurface(loadedSurface);
-	}
-
-	//Return success
-	mTexture = newTexture;
-	return mTexture != NULL;
+	buttonText.str(nextButtonText);
+	mDirty = true;
+	buildSprites();
 }
 
-bool LTexture::loadFromRenderedText(std::string textureText, SDL_Color textColor)
+void LButton::buildSprites()
 {
-	//Get rid of preexisting texture
-	free();
+	TraceScope trace("Build button sprites");
 
-	//Render text surface
-	SDL_Surface* textSurface = TTF_RenderText_Solid(gFont, textureText.c_str(), textColor);
-	if (textSurface == NULL)
-	{
-		printf("Unable to render text surface! SDL_ttf Error: %s\n", TTF_GetError());
-	}
-	else
+	mWidth = 0;
+	mHeight = 0;
+	mSpriteSheet.free();
+
+	std::string text = buttonText.str();
+	SDL_Surface* sheet = NULL;
+	for (int i = 0; i < BUTTON_SPRITE_TOTAL; ++i)
 	{
-		//Create texture from surface pixels
-		mTexture = SDL_CreateTextureFromSurface(gRenderer, textSurface);
-		if (mTexture == NULL)
+		SDL_Surface* sprite = TTF_RenderText_Blended(gFont, text.c_str(), BUTTON_SPRITE_COLORS[i]);
+		if (sprite == NULL)
 		{
-			printf("Unable to create texture from rendered text! SDL Error: %s\n", SDL_GetError());
+			printf("Unable to render button text! SDL_ttf Error: %s\n", TTF_GetError());
+			break;
 		}
-		else
+
+		//Every color renders the same size, so the first sprite sizes the sheet
+		if (sheet == NULL)
 		{
-			//Get image dimensions
-			mWidth = textSurface->w;
-			mHeight = textSurface->h;
+			sheet = SDL_CreateRGBSurfaceWithFormat(0, sprite->w, sprite->h * BUTTON_SPRITE_TOTAL, 32, SDL_PIXELFORMAT_RGBA32);
+			if (sheet == NULL)
+			{
+				printf("Unable to create button sprite sheet! SDL Error: %s\n", SDL_GetError());
+				SDL_FreeSurface(sprite);
+				break;
+			}
+			AllocationTracker::countSurface();
 		}
 
-		//Get rid of old surface
-		SDL_FreeSurface(textSurface);
+		//Copy the alpha as it is instead of blending onto the empty sheet
+		mSpriteClips[i] = { 0, sprite->h * i, sprite->w, sprite->h };
+		SDL_SetSurfaceBlendMode(sprite, SDL_BLENDMODE_NONE);
+		SDL_BlitSurface(sprite, NULL, sheet, &mSpriteClips[i]);
+		SDL_FreeSurface(sprite);
 	}
 
-	//Return success
-	return mTexture != NULL;
-}
-
-void LTexture::free()
-{
-	//Free texture if it exists
-	if (mTexture != NULL)
+	if (sheet != NULL)
 	{
-		SDL_DestroyTexture(mTexture);
-		mTexture = NULL;
-		mWidth = 0;
-		mHeight = 0;
-	}
-}
-
-void LTexture::setColor(Uint8 red, Uint8 green, Uint8 blue)
-{
-	//Modulate texture rgb
-	SDL_SetTextureColorMod(mTexture, red, green, blue);
-}
-
-void LTexture::setBlendMode(SDL_BlendMode blending)
-{
-	//Set blending function
-	SDL_SetTextureBlendMode(mTexture, blending);
-}
-
-void LTexture::setAlpha(Uint8 alpha)
-{
-	//Modulate texture alpha
-	SDL_SetTextureAlphaMod(mTexture, alpha);
-}
-
-void LTexture::render(int x, int y, SDL_Rect* clip, double angle, SDL_Point* center, SDL_RendererFlip flip)
-{
-	//Set rendering space and render to screen
-	SDL_Rect renderQuad = { x, y, mWidth, mHeight };
-
-	//Set clip rendering dimensions
-	if (clip != NULL)
-	{
-		renderQuad.w = clip->w;
-		renderQuad.h = clip->h;
+		if (mSpriteSheet.loadFromSurface(sheet))
+		{
+			mWidth = mSpriteClips[0].w;
+			mHeight = mSpriteClips[0].h;
+		}
+		SDL_FreeSurface(sheet);
 	}
-
-	//Render to screen
-	SDL_RenderCopyEx(gRenderer, mTexture, clip, &renderQuad, angle, center, flip);
-}
-
-int LTexture::getWidth()
-{
-	return mWidth;
-}
-
-int LTexture::getHeight()
-{
-	return mHeight;
-}
-
-LButton::LButton(std::string init_button_text, int init_xPos, int init_yPos)
-{
-	mPosition.x = init_xPos;
-	mPosition.y = init_yPos;
-
-	mCurrentSprite = BUTTON_SPRITE_MOUSE_OUT;
-
-	buttonText.str(init_button_text);
-	SDL_Color textColor = { 0, 0, 0, 255 };
-	gButtonTextTexture.loadFromRenderedText(buttonText.str().c_str(), textColor);
-}
-
-void LButton::setPosition(int x, int y)
-{
-	mPosition.x = x;
-	mPosition.y = y;
 }
 
-void LButton::setText(std::string nextButtonText)
+void LButton::setScreenToSwitch(int screenNewId)
 {
-	buttonText.str(nextButtonText);
-	SDL_Color textColor = { 0, 0, 0, 255 };
-	gButtonTextTexture.loadFromRenderedText(buttonText.str().c_str(), textColor);
+	screenToSwitch = screenNewId;
 }
 
-void LButton::setScreenToSwitch(int screenNewId)
+void LButton::setGameModeToSwitch(GameMode gameNewMode)
 {
-	screenToSwitch = screenNewId;
+	gameModeToSwitch = gameNewMode;
 }
 
 void LButton::handleEvent(SDL_Event* e)
@@ -518,6 +354,8 @@ void LButton::handleEvent(SDL_Event* e)
 	//If mouse event happened
 	if (e->type == SDL_MOUSEMOTION || e->type == SDL_MOUSEBUTTONDOWN || e->type == SDL_MOUSEBUTTONUP)
 	{
+		LButtonSprite previousSprite = mCurrentSprite;
+
 		//Get mouse position
 		int x, y;
 		SDL_GetMouseState(&x, &y);
@@ -531,7 +369,7 @@ void LButton::handleEvent(SDL_Event* e)
 			inside = false;
 		}
 		//Mouse is right of the button
-		else if (x > mPosition.x + gButtonTextTexture.getWidth())
+		else if (x > mPosition.x + mWidth)
 		{
 			inside = false;
 		}
@@ -541,7 +379,7 @@ void LButton::handleEvent(SDL_Event* e)
 			inside = false;
 		}
 		//Mouse below the button
-		else if (y > mPosition.y + gButtonTextTexture.getHeight())
+		else if (y > mPosition.y + mHeight)
 		{
 			inside = false;
 		}
@@ -553,559 +391,54 @@ void LButton::handleEvent(SDL_Event* e)
 		}
 		//Mouse is inside button
 		else
-		{
-			//Set mouse over sprite
-			switch (e->type)
-			{
-			case SDL_MOUSEMOTION:
-				mCurrentSprite = BUTTON_SPRITE_MOUSE_OVER_MOTION;
-				break;
-
-			case SDL_MOUSEBUTTONDOWN:
-				mCurrentSprite = BUTTON_SPRITE_MOUSE_DOWN;
-				screenId = screenToSwitch;
-
-				if (screenToSwitch == 2) {
-					resetGame(&scoreCounter);
-				}
-
-				break;
-
-			case SDL_MOUSEBUTTONUP:
-				mCurrentSprite = BUTTON_SPRITE_MOUSE_UP;
-				break;
-			}
-		}
-	}
-}
-
-bool LButton::isPressed()
-{
-	return mCurrentSprite == BUTTON_SPRITE_MOUSE_DOWN;
-}
-
-void LButton::render()
-{
-	SDL_Color textColor = { 0, 0, 0, 0 };
-	switch (mCurrentSprite)
-	{
-		case BUTTON_SPRITE_MOUSE_OUT:
-			textColor = { 0, 0, 0, 255 };
-			break;
-		case BUTTON_SPRITE_MOUSE_OVER_MOTION:
-			textColor = { 255, 0, 0, 255 };
-			break;
-		case BUTTON_SPRITE_MOUSE_DOWN:
-			textColor = { 0, 255, 0, 255 };
-			break;
-		case BUTTON_SPRITE_MOUSE_UP:
-			textColor = { 0, 0, 255, 255 };
-			break;
-		case BUTTON_SPRITE_TOTAL:
-			textColor = { 0, 0, 0, 125 };
-			break;
-	}
-
-	gButtonTextTexture.loadFromRenderedText(buttonText.str().c_str(), textColor);
-	gButtonTextTexture.render(mPosition.x, mPosition.y);
-}
-
-Dot::Dot()
-{
-	//Initialize the offsets
-	mPosX = SCREEN_WIDTH / 2;
-	mPosY = SCREEN_HEIGHT / 2;
-
-	//Set collision box dimension
-	mCollider.w = DOT_WIDTH;
-	mCollider.h = DOT_HEIGHT;
-
-	//Initialize the velocity
-	srand(time(NULL));
-	mVelX = rand() % 6 + 5;
-	mVelY = rand() % 6 + 5;
-
-	if (rand() % 100 % 1 <= 50) mVelX *= -1;
-	if (rand() % 100 % 1 <= 50) mVelY *= -1;
-}
-
-void Dot::handleEvent(SDL_Event& e)
-{
-	//If a key was pressed
-	if (e.type == SDL_KEYDOWN && e.key.repeat == 0)
-	{
-		//Adjust the velocity
-		switch (e.key.keysym.sym)
-		{
-		case SDLK_UP: mVelY -= DOT_VEL; break;
-		case SDLK_DOWN: mVelY += DOT_VEL; break;
-		case SDLK_LEFT: mVelX -= DOT_VEL; break;
-		case SDLK_RIGHT: mVelX += DOT_VEL; break;
-		}
-	}
-	//If a key was released
-	else if (e.type == SDL_KEYUP && e.key.repeat == 0)
-	{
-		//Adjust the velocity
-		switch (e.key.keysym.sym)
-		{
-		case SDLK_UP: mVelY += DOT_VEL; break;
-		case SDLK_DOWN: mVelY -= DOT_VEL; break;
-		case SDLK_LEFT: mVelX += DOT_VEL; break;
-		case SDLK_RIGHT: mVelX -= DOT_VEL; break;
-		}
-	}
-}
-
-void Dot::reset()
-{
-	//Initialize the offsets
-	mPosX = SCREEN_WIDTH / 2;
-	mPosY = SCREEN_HEIGHT / 2;
-
-	//Set collision box dimension
-	mCollider.w = DOT_WIDTH;
-	mCollider.h = DOT_HEIGHT;
-	
-	//Initialize the velocity
-	int stage = scoreCounter.getStage();
-	mVelX = rand() % std::min(5 + stage, 15) + 5;
-	mVelY = rand() % std::min(5 + stage, 15) + 5;
-
-	int higherScorePlayer = scoreCounter.getHigherScorePlayer();
-	switch (higherScorePlayer)
-	{
-	case 1:
-		mVelX *= -1;
-		break;
-	case 2:
-		mVelX *= 1;
-		break;
-	default:
-		if (rand() % 100 % 1 <= 50) mVelX *= -1;
-		break;
-	}
-
-	if (rand() % 100 % 1 <= 50) mVelY *= -1;
-}
-
-void Dot::move()
-{
-	if (isRooling == false) {
-		return;
-	}
-	//Move the dot left or right
-	mPosX += mVelX;
-	mCollider.x = mPosX;
-
-	//Move the dot up or down
-	mPosY += mVelY;
-	mCollider.y = mPosY;
-}
-
-bool Dot::collide(SDL_Rect& wall) {
-	bool isCollide = false;
-	//If the dot collided or went too far to the left or right
-	if ((mPosX < 0) || (mPosX + DOT_WIDTH > SCREEN_WIDTH) || (checkCollision(mCollider, wall)))
-	{
-		//Move back
-		mPosX -= mVelX;
-		mCollider.x = mPosX;
-		mVelX *= -1;
-		isCollide = true;
-	}
-	//If the dot collided or went too far up or down
-	if ((mPosY < 100) || (mPosY + DOT_HEIGHT > SCREEN_HEIGHT) || (checkCollision(mCollider, wall)))
-	{
-		//Move back
-		mPosY -= mVelY;
-		mCollider.y = mPosY;
-		mVelY *= -1;
-		isCollide = true;
-	}
-	return isCollide;
-}
-
-void Dot::isOutsideMap() {
-	while ((mPosX < 0) || (mPosX + DOT_WIDTH > SCREEN_WIDTH))
-	{
-		//Move back
-		mPosX -= mVelX;
-		mCollider.x = mPosX;
-		//mVelX *= -1;
-	}
-	//If the dot collided or went too far up or down
-	while ((mPosY < 100) || (mPosY + DOT_HEIGHT > SCREEN_HEIGHT))
-	{
-		//Move back
-		mPosY -= mVelY;
-		mCollider.y = mPosY;
-		//mVelY *= -1;
-	}
-}
-
-bool Dot::isCollideGoal(SDL_Rect& wall) {
-	return checkCollision(mCollider, wall);
-}
-
-void Dot::setIsRooling(bool dotState) {
-	isRooling = dotState;
-}
-
-
-void Dot::render()
-{
-	//Show the dot
-	gDotTexture.render(mPosX, mPosY);
-}
-
-PBar::PBar(int init_player, int init_barId, int init_mPosX, int init_mPosY)
-{
-	//player
-	player = init_player;
-	barId = init_barId;
-
-	//Initialize the offsets
-	mPosX = init_mPosX;
-	mPosY = init_mPosY;
-
-	//Set collision box dimension
-	mCollider.w = BAR_WIDTH;
-	mCollider.h = BAR_HEIGHT;
-
-	//Initialize the velocity
-	mVelX = 0;
-	mVelY = 0;
-
-	onBarTexture.loadFromFile("image/paddleBlu.png");
-	offBarTexture.loadFromFile("image/paddleRed.png");
-
-	mCollider.x = init_mPosX;
-	mCollider.y = init_mPosY;
-	mCollider.w = onBarTexture.getWidth();
-
-	if (barId == 2)
-	{
-		mCollider.h = onBarTexture.getHeight() * 2;
-	}
-	else
-	{
-		mCollider.h = onBarTexture.getHeight();
-	}
-}
-
-void PBar::handleEvent(SDL_Event& e)
-{
-	//If a key was pressed
-	if (e.type == SDL_KEYDOWN)
-	{
-		switch (e.key.keysym.sym)
-		{
-			case SDLK_1: 
-				if (player == 1 && barId == 1) {
-					isDisable = false;
-				} else if (player == 1 && barId == 2) {
-					isDisable = true;
-				}
-				break;
-			case SDLK_2:
-				if (player == 1 && barId == 1) {
-					isDisable = true;
-				}
-				else if (player == 1 && barId == 2) {
-					isDisable = false;
-				}
-				break;
-			case SDLK_3:
-				if (player == 1 && barId == 1) {
-					isDisable = false;
-				}
-				else if (player == 1 && barId == 2) {
-					isDisable = false;
-				}
-				break;
-			case SDLK_8:
-				if (player == 2 && barId == 1) {
-					isDisable = false;
-				}
-				else if (player == 2 && barId == 2) {
-					isDisable = true;
-				}
-				break;
-			case SDLK_9:
-				if (player == 2 && barId == 1) {
-					isDisable = true;
-				}
-				else if (player == 2 && barId == 2) {
-					isDisable = false;
-				}
-				break;
-			case SDLK_0:
-				if (player == 2 && barId == 1) {
-					isDisable = false;
-				}
-				else if (player == 2 && barId == 2) {
-					isDisable = false;
-				}
-				break;
-		}
-	}
-	//If a key was pressed
-	if (e.type == SDL_KEYDOWN && e.key.repeat == 0)
-	{
-		if (player == 1) {
-			//Adjust the velocity
-			switch (e.key.keysym.sym)
-			{
-				case SDLK_w: mVelY -= BAR_VEL; break;
-				case SDLK_s: mVelY += BAR_VEL; break;
-				//case SDLK_LEFT: mVelX -= BAR_VEL; break;
-				//case SDLK_RIGHT: mVelX += BAR_VEL; break;
-			}
-		}
-		else {
-			//Adjust the velocity
-			switch (e.key.keysym.sym)
-			{
-				case SDLK_UP: mVelY -= BAR_VEL; break;
-				case SDLK_DOWN: mVelY += BAR_VEL; break;
-				//case SDLK_LEFT: mVelX -= BAR_VEL; break;
-				//case SDLK_RIGHT: mVelX += BAR_VEL; break;
-			}
-		}
-	}
-	//If a key was released
-	else if (e.type == SDL_KEYUP && e.key.repeat == 0)
-	{
-		if (player == 1) {
-			//Adjust the velocity
-			switch (e.key.keysym.sym)
-			{
-				case SDLK_w: mVelY += BAR_VEL; break;
-				case SDLK_s: mVelY -= BAR_VEL; break;
-				//case SDLK_LEFT: mVelX -= BAR_VEL; break;
-				//case SDLK_RIGHT: mVelX += BAR_VEL; break;
-			}
-		}
-		else {
-			//Adjust the velocity
-			switch (e.key.keysym.sym)
-			{
-				case SDLK_UP: mVelY += BAR_VEL; break;
-				case SDLK_DOWN: mVelY -= BAR_VEL; break;
-				//case SDLK_LEFT: mVelX -= BAR_VEL; break;
-				//case SDLK_RIGHT: mVelX += BAR_VEL; break;
-			}
-		}
-	}
-}
-
-void PBar::move()
-{
-	if (isDisable) return;
-
-	//Move the dot left or right
-	mPosX += mVelX;
-	mCollider.x = mPosX;
-
-	//Move the dot up or down
-	mPosY += mVelY;
-	mCollider.y = mPosY;
-}
-
-void PBar::setPos(int new_mPosX, int new_mPosY) {
-	//Move the dot left or right
-	mPosX = new_mPosX;
-	mCollider.x = mPosX;
-
-	//Move the dot up or down
-	mPosY = new_mPosY;
-	mCollider.y = mPosY;
-}
-
-void PBar::reset()
-{
-	mVelX = 0;
-	mVelY = 0;
-}
-
-void PBar::collide(Dot& dot) {
-	bool isCollide = dot.collide(mCollider);
-	//If the bar collided or went too far up or down
-	if ((mPosY < 100) || (mPosY + mCollider.h > SCREEN_HEIGHT) || isCollide)
-	{
-		//Move back
-		mPosY -= mVelY;
-		mCollider.y = mPosY;
-	}
-}
-
-void PBar::render()
-{
-	if (isDisable) {
-		//SDL_SetRenderDrawColor(gRenderer, 0x00, 0x00, 0x00, 0xFF);
-		offBarTexture.render(mCollider.x, mCollider.y);
-		if (barId == 2) {
-			offBarTexture.render(mCollider.x, mCollider.y + offBarTexture.getHeight());
-		}
-	}
-	else {
-		//SDL_SetRenderDrawColor(gRenderer, 0x00, 0xFF, 0x00, 0xFF);
-		onBarTexture.render(mCollider.x, mCollider.y);
-		if (barId == 2) {
-			onBarTexture.render(mCollider.x, mCollider.y + onBarTexture.getHeight());
-		}
-	}
-	//SDL_RenderDrawRect(gRenderer, &mCollider);
-}
-
-Goal::Goal(int init_player, int init_mPosX, int init_mPosY)
-{
-	//player
-	player = init_player;
-
-	//Initialize the offsets
-	mPosX = init_mPosX;
-	mPosY = init_mPosY;
-
-	//Set collision box dimension
-	mCollider.w = GOAL_WIDTH;
-	mCollider.h = GOAL_HEIGHT;
-
-	mCollider.x = init_mPosX;
-	mCollider.y = init_mPosY;
-	mCollider.w = GOAL_WIDTH;
-	mCollider.h = GOAL_HEIGHT;
-}
-
-bool Goal::collide(Dot& dot, ScoreCounter& scoreCounter) {
-	if (dot.isCollideGoal(mCollider)) {
-		if (player == 1) {
-			scoreCounter.plusScore(2);
-		}
-		if (player == 2) {
-			scoreCounter.plusScore(1);
-		}
-		dot.reset();
-		return true;
-	}
-	return false;
-}
-
-void Goal::render()
-{
-	SDL_SetRenderDrawColor(gRenderer, 0x00, 0x00, 0xFF, 0xFF);
-	SDL_RenderDrawRect(gRenderer, &mCollider);
-}
-
-Wall::Wall(int init_width, int init_height, int init_mPosX, int init_mPosY)
-{
-	WALL_HEIGHT = init_height;
-	WALL_WIDTH = init_width;
-
-	//Initialize the offsets
-	mPosX = init_mPosX;
-	mPosY = init_mPosY;
-
-	//Set collision box dimension
-	mCollider.w = WALL_WIDTH;
-	mCollider.h = WALL_HEIGHT;
-
-	mCollider.x = init_mPosX;
-	mCollider.y = init_mPosY;
-	mCollider.w = WALL_WIDTH;
-	mCollider.h = WALL_HEIGHT;
-}
+		{
+			//Set mouse over sprite
+			switch (e->type)
+			{
+			case SDL_MOUSEMOTION:
+				mCurrentSprite = BUTTON_SPRITE_MOUSE_OVER_MOTION;
+				break;
 
-void Wall::collide(Dot& dot) {
-	dot.collide(mCollider);
-}
+			case SDL_MOUSEBUTTONDOWN:
+				mCurrentSprite = BUTTON_SPRITE_MOUSE_DOWN;
+				screenId = screenToSwitch;
+				if (gameModeToSwitch >= 0)
+				{
+					gameMode = (GameMode)gameModeToSwitch;
+				}
+				break;
 
-void Wall::render()
-{
-	SDL_SetRenderDrawColor(gRenderer, 0x00, 0x00, 0xFF, 0xFF);
-	SDL_RenderDrawRect(gRenderer, &mCollider);
-}
+			case SDL_MOUSEBUTTONUP:
+				mCurrentSprite = BUTTON_SPRITE_MOUSE_UP;
+				break;
+			}
+		}
 
-ScoreCounter::ScoreCounter()
-{
-	p1Score = 0;
-	p2Score = 0;
+		if (mCurrentSprite != previousSprite)
+		{
+			mDirty = true;
+		}
+	}
 }
 
-void ScoreCounter::reset()
+bool LButton::isPressed()
 {
-	p1Score = 0;
-	p2Score = 0;
+	return mCurrentSprite == BUTTON_SPRITE_MOUSE_DOWN;
 }
 
-void ScoreCounter::plusScore(int pId)
+void LButton::render()
 {
-	if (pId == 1) {
-		p1Score += 1;
-	}
-	if (pId == 2) {
-		p2Score += 1;
-	}
-}
-
-int ScoreCounter::getHigherScorePlayer() {
-	if (p1Score > p2Score) {
-		return 1;
-	}
-	if (p1Score < p2Score) {
-		return 2;
-	}
-	return 0;
-}
-
-int ScoreCounter::getVictoryPlayer() {
-	if (p1Score == 3) {
-		return 1;
-	}
-	if (p2Score == 3) {
-		return 2;
+	//Show current button sprite
+	if (mWidth > 0)
+	{
+		mSpriteSheet.render(mPosition.x, mPosition.y, &mSpriteClips[mCurrentSprite]);
 	}
-	return 0;
-}
-
-int ScoreCounter::getStage() {
-	return std::min(p1Score, p2Score) + 1;
+	mDirty = false;
 }
 
-void ScoreCounter::render()
+bool LButton::isDirty()
 {
-	if (screenId == 2) {
-		//In memory text stream
-		std::stringstream scoreText;
-
-		scoreText.str("");
-		scoreText << p1Score << " : " << p2Score;
-
-		//Render text
-		SDL_Color textColor = { 0, 0, 0, 255 };
-		gTextTexture.loadFromRenderedText(scoreText.str().c_str(), textColor);
-		gTextTexture.render((SCREEN_WIDTH - gTextTexture.getWidth()) / 2, 25);
-	}
-	else if (screenId == 3) {
-		//In memory text stream
-		SDL_Color textColor = { 0, 0, 0, 255 };
-
-		std::stringstream scoreText;
-		scoreText.str("");
-		scoreText << p1Score << " : " << p2Score;
-
-		//Render text
-		gTextTexture.loadFromRenderedText(scoreText.str().c_str(), textColor);
-		gTextTexture.render((SCREEN_WIDTH - gTextTexture.getWidth()) / 2, 250);
-
-		std::stringstream winnerText;
-		winnerText.str("");
-		winnerText << "Player " << this->getVictoryPlayer() << " win";
-
-		gWinnerTexture.loadFromRenderedText(winnerText.str().c_str(), textColor);
-		gWinnerTexture.render((SCREEN_WIDTH - gWinnerTexture.getWidth()) / 2, 300);
-	}
+	return mDirty;
 }
 
 MainMenu::MainMenu()
@@ -1123,14 +456,22 @@ MainMenu::MainMenu()
 	gStartButton.setPosition(centerX, 300);
 	gStartButton.setText("Standard Mode");
 	gStartButton.setScreenToSwitch(2);
+	gStartButton.setGameModeToSwitch(GAME_MODE_STANDARD);
 
 	gAdvanceButton.setPosition(centerX, 350);
 	gAdvanceButton.setText("Expert Mode");
 	gAdvanceButton.setScreenToSwitch(2);
+	gAdvanceButton.setGameModeToSwitch(GAME_MODE_EXPERT);
 
 	gBotButton.setPosition(centerX, 400);
 	gBotButton.setText("Bot Mode");
 	gBotButton.setScreenToSwitch(2);
+	gBotButton.setGameModeToSwitch(GAME_MODE_BOT);
+
+	gMultiballButton.setPosition(centerX, 450);
+	gMultiballButton.setText("Multiball Mode");
+	gMultiballButton.setScreenToSwitch(2);
+	gMultiballButton.setGameModeToSwitch(GAME_MODE_MULTIBALL);
 
 	gExitButton.setPosition(centerX, 500);
 	gExitButton.setText("Exit");
@@ -1144,6 +485,7 @@ void MainMenu::render()
 	gStartButton.render();
 	//gAdvanceButton.render();
 	gBotButton.render();
+	gMultiballButton.render();
 	gExitButton.render();
 }
 
@@ -1152,9 +494,16 @@ void MainMenu::handleEvent(SDL_Event* e)
 	gStartButton.handleEvent(e);
 	gAdvanceButton.handleEvent(e);
 	gBotButton.handleEvent(e);
+	gMultiballButton.handleEvent(e);
 	gExitButton.handleEvent(e);
 }
 
+bool MainMenu::isDirty()
+{
+	//The hidden expert button isn't rendered, so it never turns clean
+	return gStartButton.isDirty() || gBotButton.isDirty() || gMultiballButton.isDirty() || gExitButton.isDirty();
+}
+
 ResultMenu::ResultMenu()
 {
 	SDL_Color textColor = { 0, 0, 0, 255 };
@@ -1190,6 +539,11 @@ void ResultMenu::handleEvent(SDL_Event* e)
 	gMainmenuButton.handleEvent(e);
 }
 
+bool ResultMenu::isDirty()
+{
+	return gRestartButton.isDirty() || gMainmenuButton.isDirty();
+}
+
 bool init()
 {
 	//Initialization flag
@@ -1261,42 +615,375 @@ bool init()
 
 bool loadMedia()
 {
+	TraceScope trace("Load media");
+
 	//Loading success flag
 	bool success = true;
 
+	//Pack the scene images into one atlas so bars and dot batch together
+	std::vector<TextureHandle> sceneTextures = gAssets.getPackedTextures(SCENE_IMAGE_PATHS);
+
 	//Load press texture
-	if (!gDotTexture.loadFromFile("image/ball.png"))
+	gDotTexture = sceneTextures[0];
+	if (gDotTexture->getWidth() == 0)
 	{
 		printf("Failed to load dot texture!\n");
 		success = false;
 	}
 
-	if (!gBackGroundTexture.loadFromFile("image/groundGrass_mown1.png"))
+	gBarOnTexture = sceneTextures[1];
+	gBarOffTexture = sceneTextures[2];
+	if (gBarOnTexture->getHeight() == 0 || gBarOffTexture->getHeight() == 0)
+	{
+		printf("Failed to load bar textures!\n");
+		success = false;
+	}
+
+	gBackGroundTexture = sceneTextures[3];
+	if (gBackGroundTexture->getWidth() == 0)
 	{
 		printf("Failed to load dot texture!\n");
 		success = false;
 	}
 
 	//Open the font
-	gFont = TTF_OpenFont("font/Cartos.ttf", 50);
+	gFont = gAssets.openFont(FONT_PATH, 50);
 	if (gFont == NULL)
 	{
 		printf("Failed to load lazy font! SDL_ttf Error: %s\n", TTF_GetError());
 		success = false;
 	}
+	else if (!gTextAtlas.build(gRenderer, gFont))
+	{
+		printf("Failed to build glyph atlas!\n");
+		success = false;
+	}
+
+	//Load the arena
+	gArena = Arena::load(ARENA_PATH);
+	if (gArena == NULL)
+	{
+		printf("Playing on the standard arena instead\n");
+		gArena = Arena::getStandard();
+	}
 
 	return success;
 }
 
-void resetGame(ScoreCounter* scorecounter)
+bool runLoadingScreen()
+{
+	TraceScope trace("Loading screen");
+
+	//Map the packed assets
+	if (!gAssets.openArchive(ASSET_ARCHIVE_PATH))
+	{
+		printf("No asset archive at %s, loading loose files\n", ASSET_ARCHIVE_PATH);
+	}
+
+	//Decode the loose files on the loader thread while the window stays responsive
+	std::vector<std::string> paths = SCENE_IMAGE_PATHS;
+	paths.push_back(FONT_PATH);
+	gAssets.prefetch(paths);
+
+	SDL_Event e;
+	while (!gAssets.updatePrefetch())
+	{
+		while (SDL_PollEvent(&e) != 0)
+		{
+			if (e.type == SDL_QUIT)
+			{
+				return false;
+			}
+		}
+
+		//Nothing is loaded yet, so the progress bar is drawn with plain rects
+		SDL_SetRenderDrawColor(gRenderer, 0xFF, 0xFF, 0xFF, 0xFF);
+		SDL_RenderClear(gRenderer);
+
+		SDL_Rect outline = { (SCREEN_WIDTH - LOADING_BAR_WIDTH) / 2, (SCREEN_HEIGHT - LOADING_BAR_HEIGHT) / 2, LOADING_BAR_WIDTH, LOADING_BAR_HEIGHT };
+		SDL_Rect fill = { outline.x + 2, outline.y + 2, (int)((outline.w - 4) * gAssets.getPrefetchProgress()), outline.h - 4 };
+		SDL_SetRenderDrawColor(gRenderer, 0x00, 0x00, 0x00, 0xFF);
+		SDL_RenderDrawRect(gRenderer, &outline);
+		SDL_RenderFillRect(gRenderer, &fill);
+
+		//Vsync paces the loop
+		SDL_RenderPresent(gRenderer);
+	}
+	return true;
+}
+
+bool needsMenuRedraw(const SDL_Event& e)
+{
+	switch (e.type)
+	{
+	//Exposed or resized windows and lost render targets need a fresh frame
+	case SDL_WINDOWEVENT:
+	case SDL_RENDER_TARGETS_RESET:
+	case SDL_RENDER_DEVICE_RESET:
+		return true;
+
+	//Debug keys toggle the overlay
+	case SDL_KEYDOWN:
+		return true;
+	}
+	return false;
+}
+
+void renderPlayfield(Match& match)
+{
+	SDL_SetRenderDrawColor(gRenderer, 0xFF, 0xFF, 0xFF, 0xFF);
+	SDL_RenderClear(gRenderer);
+
+	//Tile the background below the wall
+	for (int background_x = 0; background_x < SCREEN_WIDTH; background_x += gBackGroundTexture->getWidth())
+	{
+		for (int background_y = PLAYFIELD_TOP; background_y < SCREEN_HEIGHT; background_y += gBackGroundTexture->getHeight())
+		{
+			gBackGroundTexture->render(background_x, background_y);
+		}
+	}
+
+	//Render goals and walls, the invisible walls lie outside the screen
+	SDL_SetRenderDrawColor(gRenderer, 0x00, 0x00, 0xFF, 0xFF);
+	EntityStore& entities = match.getEntities();
+	for (int i = 0; i < entities.getGoalCount(); ++i)
+	{
+		SDL_Rect goal = { entities.goalX[i], entities.goalY[i], entities.goalWidth[i], entities.goalHeight[i] };
+		SDL_RenderDrawRect(gRenderer, &goal);
+	}
+	for (int i = 0; i < entities.getWallCount(); ++i)
+	{
+		SDL_Rect wall = { entities.wallX[i], entities.wallY[i], entities.wallWidth[i], entities.wallHeight[i] };
+		SDL_RenderDrawRect(gRenderer, &wall);
+	}
+}
+
+void renderMatch(Match& match, float alpha)
+{
+	gSpriteBatch.begin(gRenderer);
+
+	//Render bars, the front bar is two paddles stacked
+	for (int i = 0; i < match.getBarCount(); ++i)
+	{
+		PBar bar = match.getBar(i);
+		SDL_Rect box = bar.getRenderBox(alpha);
+		TextureHandle& barTexture = bar.isDisabled() ? gBarOffTexture : gBarOnTexture;
+		for (int y = box.y; y < box.y + box.h; y += barTexture->getHeight())
+		{
+			gSpriteBatch.draw(*barTexture, box.x, y);
+		}
+	}
+
+	//Render extra balls, then the ball in play on top
+	EntityStore& entities = match.getEntities();
+	for (int i = 1; i < entities.getBallCount(); ++i)
+	{
+		SDL_Rect ball = Dot(entities, i).getRenderBox(alpha);
+		gSpriteBatch.draw(*gDotTexture, ball.x, ball.y);
+	}
+
+	//Render dot last, it shares the atlas with the bars so it still draws above them in the same call
+	SDL_Rect dot = match.getDot().getRenderBox(alpha);
+	gSpriteBatch.draw(*gDotTexture, dot.x, dot.y);
+
+	gSpriteBatch.end();
+}
+
+void renderScore(ScoreCounter& scoreCounter, int y)
+{
+	gScoreText.setValues(scoreCounter.getScore(1), scoreCounter.getScore(2));
+
+	//Render text
+	SDL_Color textColor = { 0, 0, 0, 255 };
+	gScoreText.renderCentered(gTextAtlas, SCREEN_WIDTH / 2, y, textColor);
+}
+
+#ifdef TRACK_ALLOCATIONS
+//SDL's own allocator, called by the counting wrappers
+SDL_malloc_func gSdlMalloc = NULL;
+SDL_calloc_func gSdlCalloc = NULL;
+SDL_realloc_func gSdlRealloc = NULL;
+SDL_free_func gSdlFree = NULL;
+
+void* SDLCALL countedSdlMalloc(size_t size)
+{
+	AllocationTracker::countAllocation(size);
+	return gSdlMalloc(size);
+}
+
+void* SDLCALL countedSdlCalloc(size_t count, size_t size)
+{
+	AllocationTracker::countAllocation(count * size);
+	return gSdlCalloc(count, size);
+}
+
+void* SDLCALL countedSdlRealloc(void* memory, size_t size)
+{
+	AllocationTracker::countAllocation(size);
+	return gSdlRealloc(memory, size);
+}
+
+void SDLCALL countedSdlFree(void* memory)
+{
+	if (memory != NULL)
+	{
+		AllocationTracker::countFree();
+	}
+	gSdlFree(memory);
+}
+
+void hookSdlAllocator()
+{
+	SDL_GetMemoryFunctions(&gSdlMalloc, &gSdlCalloc, &gSdlRealloc, &gSdlFree);
+	SDL_SetMemoryFunctions(countedSdlMalloc, countedSdlCalloc, countedSdlRealloc, countedSdlFree);
+}
+#endif
+
+void renderProfiler(Profiler& profiler)
+{
+	//Dark panel in the bottom left corner, the graph has one column per frame and is two frame budgets tall
+	const int graphHeight = 120;
+	const double graphMs = 2000.0 / 60.0;
+	int lineHeight = gTextAtlas.getLineHeight();
+	int panelHeight = std::max(graphHeight, (PROFILE_ZONE_TOTAL + 3) * lineHeight);
+	SDL_Rect panel = { 0, SCREEN_HEIGHT - panelHeight - 20, Profiler::HISTORY_FRAMES + 380, panelHeight + 20 };
+	SDL_Rect graph = { 10, SCREEN_HEIGHT - graphHeight - 10, Profiler::HISTORY_FRAMES, graphHeight };
+
+	SDL_SetRenderDrawBlendMode(gRenderer, SDL_BLENDMODE_BLEND);
+	SDL_SetRenderDrawColor(gRenderer, 0x00, 0x00, 0x00, 0xC0);
+	SDL_RenderFillRect(gRenderer, &panel);
+
+	static const SDL_Color zoneColors[PROFILE_ZONE_TOTAL] = {
+		{ 0xFF, 0xD0, 0x40, 0xFF },
+		{ 0x40, 0xC0, 0xFF, 0xFF },
+		{ 0xFF, 0x60, 0x60, 0xFF },
+		{ 0x80, 0x80, 0x80, 0xFF },
+		{ 0x60, 0xE0, 0x60, 0xFF },
+		{ 0xE0, 0x80, 0xFF, 0xFF },
+		{ 0xFF, 0xFF, 0xFF, 0xFF }
+	};
+
+	//Stack the zones of every frame, one fill call per zone
+	int totalFrames = profiler.getTotalFrames();
+	double stackMs[Profiler::HISTORY_FRAMES] = {};
+	//Kept between calls so the overlay doesn't show up in the allocation counts
+	static std::vector<SDL_Rect> columns;
+	columns.reserve(Profiler::HISTORY_FRAMES);
+	for (int zone = 0; zone < PROFILE_ZONE_TOTAL; ++zone)
+	{
+		columns.clear();
+		for (int i = 0; i < totalFrames; ++i)
+		{
+			double zoneMs = profiler.getZoneMs(i, (ProfileZone)zone);
+			int bottom = (int)(std::min(stackMs[i], graphMs) / graphMs * graphHeight);
+			int top = (int)(std::min(stackMs[i] + zoneMs, graphMs) / graphMs * graphHeight);
+			stackMs[i] += zoneMs;
+			if (top > bottom)
+			{
+				SDL_Rect column = { graph.x + graph.w - 1 - i, graph.y + graph.h - top, 1, top - bottom };
+				columns.push_back(column);
+			}
+		}
+
+		SDL_Color color = zoneColors[zone];
+		SDL_SetRenderDrawColor(gRenderer, color.r, color.g, color.b, color.a);
+		SDL_RenderFillRects(gRenderer, columns.data(), (int)columns.size());
+	}
+
+	//Whatever no zone covered
+	columns.clear();
+	for (int i = 0; i < totalFrames; ++i)
+	{
+		int bottom = (int)(std::min(stackMs[i], graphMs) / graphMs * graphHeight);
+		int top = (int)(std::min(profiler.getFrameMs(i), graphMs) / graphMs * graphHeight);
+		if (top > bottom)
+		{
+			SDL_Rect column = { graph.x + graph.w - 1 - i, graph.y + graph.h - top, 1, top - bottom };
+			columns.push_back(column);
+		}
+	}
+	SDL_SetRenderDrawColor(gRenderer, 0x40, 0x40, 0x40, 0xFF);
+	SDL_RenderFillRects(gRenderer, columns.data(), (int)columns.size());
+
+	//The 60 FPS budget
+	int budgetY = graph.y + graphHeight / 2;
+	SDL_SetRenderDrawColor(gRenderer, 0xFF, 0x00, 0x00, 0xFF);
+	SDL_RenderDrawLine(gRenderer, graph.x, budgetY, graph.x + graph.w - 1, budgetY);
+
+	//Percentiles and the last frame's zones
+	char line[64];
+	int textX = graph.x + graph.w + 10;
+	int textY = SCREEN_HEIGHT - 10 - (PROFILE_ZONE_TOTAL + 3) * lineHeight;
+	SDL_Color textColor = { 0xFF, 0xFF, 0xFF, 0xFF };
+	SDL_snprintf(line, sizeof(line), "p50 %.2f  p99 %.2f  max %.2f ms",
+		profiler.getFramePercentileMs(50.0), profiler.getFramePercentileMs(99.0), profiler.getMaxFrameMs());
+	gTextAtlas.renderText(textX, textY, line, textColor);
+	for (int zone = 0; zone < PROFILE_ZONE_TOTAL; ++zone)
+	{
+		SDL_snprintf(line, sizeof(line), "%s %.2f ms, %lld allocs", Profiler::getZoneName((ProfileZone)zone),
+			profiler.getZoneMs(0, (ProfileZone)zone), profiler.getZoneAllocations(0, (ProfileZone)zone));
+		gTextAtlas.renderText(textX, textY + (zone + 1) * lineHeight, line, zoneColors[zone]);
+	}
+
+	SDL_snprintf(line, sizeof(line), "Draw calls %d, sprites %d in %d", profiler.getDrawCalls(0), gSpriteBatch.getSpriteCount(), gSpriteBatch.getDrawCalls());
+	gTextAtlas.renderText(textX, textY + (PROFILE_ZONE_TOTAL + 1) * lineHeight, line, textColor);
+
+	//A steady frame shouldn't allocate, anything that does shows in red
+	AllocationCounts allocations = profiler.getFrameAllocations(0);
+	if (AllocationTracker::isEnabled())
+	{
+		SDL_snprintf(line, sizeof(line), "Allocs %lld (%lld bytes), textures %d, surfaces %d",
+			allocations.allocations, allocations.bytes, allocations.textures, allocations.surfaces);
+	}
+	else
+	{
+		SDL_snprintf(line, sizeof(line), "Textures %d, surfaces %d (allocs not tracked)", allocations.textures, allocations.surfaces);
+	}
+	bool allocated = allocations.allocations > 0 || allocations.textures > 0 || allocations.surfaces > 0;
+	SDL_Color allocationColor = { 0xFF, 0x60, 0x60, 0xFF };
+	gTextAtlas.renderText(textX, textY + (PROFILE_ZONE_TOTAL + 2) * lineHeight, line, allocated ? allocationColor : textColor);
+}
+
+void handleGlobalEvents(SDL_Event& e)
 {
-	scoreCounter.reset();
+	//Target textures lose their content when the device resets
+	if (e.type == SDL_RENDER_TARGETS_RESET || e.type == SDL_RENDER_DEVICE_RESET)
+	{
+		gPlayfieldLayer.invalidate();
+	}
+
+	if (e.type != SDL_KEYDOWN || e.key.repeat != 0)
+	{
+		return;
+	}
+
+	switch (e.key.keysym.sym)
+	{
+	//Show or hide the profiler
+	case SDLK_F3:
+		gProfiler.toggleOverlay();
+		break;
+
+	//Dump the recent zones of every thread for Perfetto
+	case SDLK_F4:
+		if (TraceRecorder::writeChromeTrace(TRACE_FILE_PATH))
+		{
+			printf("Trace written to %s\n", TRACE_FILE_PATH);
+		}
+		break;
+	}
 }
 
 void close()
 {
 	//Free loaded images
-	gDotTexture.free();
+	gDotTexture.reset();
+	gBarOnTexture.reset();
+	gBarOffTexture.reset();
+	gBackGroundTexture.reset();
+	gAssets.printStats();
+	gTextAtlas.free();
+	gPlayfieldLayer.free();
 
 	//Free global font
 	TTF_CloseFont(gFont);
@@ -1314,53 +1001,33 @@ void close()
 	SDL_Quit();
 }
 
-bool checkCollision(SDL_Rect a, SDL_Rect b)
+int main(int argc, char* args[])
 {
-	//The sides of the rectangles
-	int leftA, leftB;
-	int rightA, rightB;
-	int topA, topB;
-	int bottomA, bottomB;
-
-	//Calculate the sides of rect A
-	leftA = a.x;
-	rightA = a.x + a.w;
-	topA = a.y;
-	bottomA = a.y + a.h;
-
-	//Calculate the sides of rect B
-	leftB = b.x;
-	rightB = b.x + b.w;
-	topB = b.y;
-	bottomB = b.y + b.h;
-
-	//If any of the sides from A are outside of B
-	if (bottomA <= topB)
-	{
-		return false;
-	}
-
-	if (topA >= bottomB)
-	{
-		return false;
-	}
-
-	if (rightA <= leftB)
+#ifdef TRACK_ALLOCATIONS
+	hookSdlAllocator();
+#endif
+	TraceRecorder::setThreadName("Main");
+
+	//Netplay against another copy of the game, started as
+	//netplay <player> <local port> <remote port> [remote address] [latency ms] [loss percent]
+	int netplayPlayer = 0;
+	UdpTransport netTransport;
+	LaggyTransport laggyTransport(&netTransport, SDL_GetPerformanceCounter());
+	if (argc > 4 && strcmp(args[1], "netplay") == 0)
 	{
-		return false;
-	}
+		netplayPlayer = atoi(args[2]) == 2 ? 2 : 1;
+		const char* remoteAddress = argc > 5 ? args[5] : "127.0.0.1";
+		if (!netTransport.open(atoi(args[3]), remoteAddress, atoi(args[4])))
+		{
+			printf("Netplay is off\n");
+			netplayPlayer = 0;
+		}
 
-	if (leftA >= rightB)
-	{
-		return false;
+		//Optional lag for trying netplay on one machine, jittering by a quarter of the latency
+		double latency = argc > 6 ? atof(args[6]) / 1000.0 : 0.0;
+		laggyTransport.setLag(latency, latency / 4.0, argc > 7 ? atoi(args[7]) : 0);
 	}
 
-	//If none of the sides from A are outside B
-	return true;
-}
-
-int main(int argc, char* args[])
-{
 	//Start up SDL and create window
 	if (!init())
 	{
@@ -1368,8 +1035,12 @@ int main(int argc, char* args[])
 	}
 	else
 	{
-		//Load media
-		if (!loadMedia())
+		//Decode in the background, then upload media
+		if (!runLoadingScreen())
+		{
+			printf("Closed while loading\n");
+		}
+		else if (!loadMedia())
 		{
 			printf("Failed to load media!\n");
 		}
@@ -1378,7 +1049,7 @@ int main(int argc, char* args[])
 			//Main loop flag
 			bool quit = false;
 			bool isIngame = false;
-			bool isInitialGame = false;
+			bool isInitialGame = true;
 			bool isNewStage = false;
 
 			MainMenu mainmenu;
@@ -1392,44 +1063,81 @@ int main(int argc, char* args[])
 
 			//The application timer
 			LTimer timer;
-			LTimer countdownTimer;
 
 			//The frames per second timer
 			LTimer fpsTimer;
 
-			//In memory text stream
-			std::stringstream timeText;
-			std::stringstream countdownTimeText;
+			//HUD lines, formatted only when their number changes
+			HudText clockText("", "", "s");
+			HudText fpsText("", "", " FPS");
+			HudText countdownText;
+			HudText winnerText("Player ", "", " win");
 
-			//In memory text stream
-			std::stringstream fpsTimeText;
+			//Simulation time not yet consumed by a tick
+			double simAccumulator = 0.0;
+			Uint64 lastFrameCounter = SDL_GetPerformanceCounter();
 
 			//Start counting frames per second
 			int countedFrames = 0;
 			fpsTimer.start();
 			timer.start();
-			countdownTimer.start();
 
-			//The dot that will be moving around on the screen
-			Dot dot;
+			//The match being played
+			Match match;
+			match.setArena(gArena);
+			match.setProfiler(&gProfiler);
+
+			//Records the match being played
+			ReplayWriter replayWriter;
 
-			PBar p1_bar1_obj(1, 1, 50, SCREEN_HEIGHT / 2 - 50);
-			PBar p1_bar2_obj(1, 2, SCREEN_WIDTH / 2 - 300, SCREEN_HEIGHT / 2 - 50);
-			PBar p2_bar1_obj(2, 1, SCREEN_WIDTH - 100, SCREEN_HEIGHT / 2 - 50);
-			PBar p2_bar2_obj(2, 2, SCREEN_WIDTH / 2 + 300, SCREEN_HEIGHT / 2 - 50);
+			//Plays the match against the remote peer in netplay, and how many matches were played so far
+			RollbackSession netSession;
+			int netplayMatches = 0;
 
-			Goal p1Goal(1, 0, SCREEN_HEIGHT / 2 - 150);
-			Goal p2Goal(2, SCREEN_WIDTH - 40, SCREEN_HEIGHT / 2 - 150);
+			//Plays player 2 in Bot Mode
+			BotController bot(2, BOT_POLICY_PREDICTIVE);
+			bot.setMaxSpeed(BOT_MODE_BAR_SPEED);
 
-			Wall topWall(SCREEN_WIDTH, 100, 0, 0);
+			//Menus present only when something on them changed
+			int shownScreenId = -1;
+			bool menuDirty = true;
 
 			//While application is running
 			while (!quit)
 			{
+				//Idle menus sleep until an event arrives instead of redrawing every refresh
+				//After a netplay match the session still sends inputs the other peer may be waiting on, so it sleeps a tick at most
+				if ((screenId == 1 || screenId == 3) && screenId == shownScreenId && !menuDirty)
+				{
+					SDL_WaitEventTimeout(NULL, netSession.isRunning() ? 1000 / SIM_TICKS_PER_SECOND : MENU_IDLE_TIMEOUT_MS);
+				}
+				if (screenId != shownScreenId)
+				{
+					shownScreenId = screenId;
+					menuDirty = true;
+				}
+
+				//Frames of a menu that didn't change keep the last presented frame
+				bool presentFrame = true;
+
+				gProfiler.beginFrame();
+
+				//Measure the real time the last frame took
+				Uint64 frameCounter = SDL_GetPerformanceCounter();
+				double frameSeconds = (double)(frameCounter - lastFrameCounter) / SDL_GetPerformanceFrequency();
+				lastFrameCounter = frameCounter;
+
+				//Avoid the spiral of death after a stall, the game slows down instead
+				if (frameSeconds > MAX_FRAME_SECONDS)
+				{
+					frameSeconds = MAX_FRAME_SECONDS;
+				}
+
 				if (screenId == 0) {
 					quit = true;
 				}
 				else if (screenId == 1) {
+					gProfiler.beginZone(PROFILE_ZONE_EVENTS);
 					while (SDL_PollEvent(&e) != 0)
 					{
 						if (e.type == SDL_QUIT)
@@ -1437,43 +1145,55 @@ int main(int argc, char* args[])
 							quit = true;
 						}
 
+						menuDirty = menuDirty || needsMenuRedraw(e);
+						handleGlobalEvents(e);
 						mainmenu.handleEvent(&e);
 					}
+					gProfiler.endZone();
 
-					//Clear screen
-					SDL_SetRenderDrawColor(gRenderer, 0xFF, 0xFF, 0xFF, 0xFF);
-					SDL_RenderClear(gRenderer);
+					//The overlay shows live numbers, so it keeps the menu redrawing
+					menuDirty = menuDirty || mainmenu.isDirty() || gProfiler.isOverlayShown();
+					presentFrame = menuDirty;
+					if (menuDirty)
+					{
+						//Clear screen
+						SDL_SetRenderDrawColor(gRenderer, 0xFF, 0xFF, 0xFF, 0xFF);
+						SDL_RenderClear(gRenderer);
 
-					mainmenu.render();
+						gProfiler.beginZone(PROFILE_ZONE_TEXT);
+						mainmenu.render();
+						gProfiler.endZone();
+					}
 				}
 				else if (screenId == 2) {
 					if (isInitialGame == true)
 					{
-						p1_bar1_obj.setPos(50, SCREEN_HEIGHT / 2 - 50);
-						p1_bar2_obj.setPos(SCREEN_WIDTH / 2 - 300, SCREEN_HEIGHT / 2 - 50);
-						p2_bar1_obj.setPos(SCREEN_WIDTH - 100, SCREEN_HEIGHT / 2 - 50);
-						p2_bar2_obj.setPos(SCREEN_WIDTH / 2 + 300, SCREEN_HEIGHT / 2 - 50);
-						p1_bar1_obj.reset();
-						p1_bar2_obj.reset();
-						p2_bar1_obj.reset();
-						p2_bar2_obj.reset();
-						dot.reset();
+						if (netplayPlayer > 0)
+						{
+							//Both peers play standard rules with the same serves, packets of earlier matches are ignored
+							Uint64 seed = NETPLAY_SEED + netplayMatches;
+							match.setSeed(seed);
+							match.setExtraBalls(0);
+							match.reset();
+							match.setRecorder(NULL);
+							netSession.start(&match, netplayPlayer, &laggyTransport, (Uint32)seed);
+							netplayMatches += 1;
+						}
+						else
+						{
+							//Fresh serves every game
+							match.setSeed(SDL_GetPerformanceCounter());
+							match.setExtraBalls(gameMode == GAME_MODE_MULTIBALL ? MULTIBALL_EXTRA_BALLS : 0);
+							match.reset();
+							match.setRecorder(replayWriter.open(REPLAY_PATH, match) ? &replayWriter : NULL);
+						}
 						timer.start();
 						isInitialGame = false;
-						scoreCounter.reset();
-						countdownTimer.start();
-					}
-					if (countdownTimer.getTicks() >= 1000 / 60)
-					{
-						dot.setIsRooling(false);
-					}
-					if (countdownTimer.getTicks() >= 3000)
-					{
-						countdownTimer.stop();
-						dot.setIsRooling(true);
+						simAccumulator = 0.0;
 					}
 
 					//Handle events on queue
+					gProfiler.beginZone(PROFILE_ZONE_EVENTS);
 					while (SDL_PollEvent(&e) != 0)
 					{
 						//User requests quit
@@ -1486,16 +1206,18 @@ int main(int argc, char* args[])
 						{
 							if (e.key.keysym.sym == SDLK_ESCAPE)
 							{
+								replayWriter.finish(match);
+								netSession.stop();
 								screenId = 1;
 								isInitialGame = true;
 							}
+
 						}
 
-						p1_bar1_obj.handleEvent(e);
-						p1_bar2_obj.handleEvent(e);
-						p2_bar1_obj.handleEvent(e);
-						p2_bar2_obj.handleEvent(e);
+						handleGlobalEvents(e);
+						match.handleEvent(e);
 					}
+					gProfiler.endZone();
 
 					//Action 
 					//Calculate and correct fps
@@ -1505,107 +1227,140 @@ int main(int argc, char* args[])
 						avgFPS = 0;
 					}
 
-					int victory = scoreCounter.getVictoryPlayer();
-					if (victory == 1 || victory == 2) {
+					//A netplay match is only over once every input that led there arrived
+					if (netSession.isRunning() ? netSession.isFinished() : match.isOver()) {
+						if (netSession.isRunning())
+						{
+							RollbackStats& stats = netSession.getStats();
+							printf("Netplay: %d rollbacks, longest %d ticks, slowest %.3f ms, %d stalled frames%s\n", stats.rollbacks,
+								stats.longestRollback, stats.slowestRollbackSeconds * 1000.0, stats.stalledFrames,
+								netSession.isDesynced() ? ", the peers desynced" : "");
+						}
+						replayWriter.finish(match);
 						isInitialGame = true;
 						timer.stop();
 						screenId = 3;
 					} 
 
-					//Move the dot and check collision
-					dot.move();
-					p1_bar1_obj.move();
-					p1_bar2_obj.move();
-					p2_bar1_obj.move();
-					p2_bar2_obj.move();
-
-					p1_bar1_obj.collide(dot);
-					p1_bar2_obj.collide(dot);
-					p2_bar1_obj.collide(dot);
-					p2_bar2_obj.collide(dot);
-					if (p1Goal.collide(dot, scoreCounter) 
-						|| p2Goal.collide(dot, scoreCounter)) {
-						countdownTimer.start();
+					//Advance the simulation in fixed ticks for the time that passed
+					simAccumulator += frameSeconds;
+					gProfiler.beginZone(PROFILE_ZONE_SIMULATION);
+					laggyTransport.advance(frameSeconds);
+					while (simAccumulator >= SIM_TICK_SECONDS)
+					{
+						if (netSession.isRunning())
+						{
+							//Too far ahead of the peer it plays no tick, which slows this side down until they catch up
+							netSession.advance();
+						}
+						else
+						{
+							if (gameMode == GAME_MODE_BOT)
+							{
+								bot.update(match);
+							}
+							match.tick();
+						}
+						simAccumulator -= SIM_TICK_SECONDS;
 					}
+					gProfiler.endZone();
 
-					//Clear screen
-					SDL_SetRenderDrawColor(gRenderer, 0xFF, 0xFF, 0xFF, 0xFF);
-					SDL_RenderClear(gRenderer);
+					//How far the next tick has progressed, for rendering in between ticks
+					float tickAlpha = (float)(simAccumulator / SIM_TICK_SECONDS);
 
-					//Render Background
-					for (int background_x = 0; background_x < SCREEN_WIDTH; background_x += gBackGroundTexture.getWidth())
+					//Render background, goals and wall, the layer covers the whole screen so no clear is needed
+					gProfiler.beginZone(PROFILE_ZONE_BACKGROUND);
+					if (gPlayfieldLayer.beginRedraw(gRenderer, SCREEN_WIDTH, SCREEN_HEIGHT))
 					{
-						for (int background_y = 100; background_y < SCREEN_HEIGHT; background_y += gBackGroundTexture.getHeight())
-						{
-							gBackGroundTexture.render(background_x, background_y);
-						}
+						renderPlayfield(match);
+						gPlayfieldLayer.endRedraw();
 					}
+					gPlayfieldLayer.render(0, 0);
+					gProfiler.endZone();
 
-					//Render wall
-					p1_bar1_obj.render();
-					p1_bar2_obj.render();
-					p2_bar1_obj.render();
-					p2_bar2_obj.render();
-					p1Goal.render();
-					p2Goal.render();
-					topWall.render();
+					//Render bars and dot
+					gProfiler.beginZone(PROFILE_ZONE_SPRITES);
+					renderMatch(match, tickAlpha);
+					gProfiler.endZone();
 
 					//Set text to be rendered
-					timeText.str("");
-					timeText << (std::floor(timer.getTicks() / 1000.f)) << "s";
+					gProfiler.beginZone(PROFILE_ZONE_TEXT);
+					clockText.setValue((int)(timer.getTicks() / 1000));
 
 					//Set text to be rendered
-					fpsTimeText.str("");
-					fpsTimeText << std::floor(avgFPS) << " FPS";
-
-					countdownTimeText.str("");
-					countdownTimeText << std::ceil((4000 - countdownTimer.getTicks()) / 1000);
-
-					//Render text
-					if (!gTimeTextTexture.loadFromRenderedText(timeText.str().c_str(), textColor))
-					{
-						printf("Unable to render time texture!\n");
-					}
+					fpsText.setValue((int)avgFPS);
 
-					gFPSTextTexture.loadFromRenderedText(fpsTimeText.str().c_str(), textColor);
-					gNewStateCountdownTextTexture.loadFromRenderedText(countdownTimeText.str().c_str(), textColor);
-
-					//Render dot
-					dot.render();
+					countdownText.setValue((match.getCountdownTicks() + SIM_TICKS_PER_SECOND - 1) / SIM_TICKS_PER_SECOND);
 
 					//Render current frame
-					scoreCounter.render();
+					renderScore(match.getScoreCounter(), 25);
 
-					//Render textures
-					gTimeTextTexture.render((SCREEN_WIDTH - gTimeTextTexture.getWidth()), (gTimeTextTexture.getHeight()));
-					gFPSTextTexture.render((SCREEN_WIDTH - gFPSTextTexture.getWidth()), 0);
+					//Render text
+					clockText.renderRightAligned(gTextAtlas, SCREEN_WIDTH, gTextAtlas.getLineHeight(), textColor);
+					fpsText.renderRightAligned(gTextAtlas, SCREEN_WIDTH, 0, textColor);
 
-					if ((countdownTimer.getTicks() != 0 && countdownTimer.getTicks() < 3000) || ( timer.getTicks() != 0  && timer.getTicks() < 3000))
+					if (match.getCountdownTicks() > 0)
 					{
-						gNewStateCountdownTextTexture.render(SCREEN_WIDTH / 2, SCREEN_HEIGHT / 2);
+						countdownText.render(gTextAtlas, SCREEN_WIDTH / 2, SCREEN_HEIGHT / 2, textColor);
 					}
+					gProfiler.endZone();
 				}
 				else if (screenId == 3)
 				{
+					//Keep sending the last inputs, the peer may still be waiting for them to finish
+					if (netSession.isRunning())
+					{
+						laggyTransport.advance(frameSeconds);
+						netSession.advance();
+					}
+
+					gProfiler.beginZone(PROFILE_ZONE_EVENTS);
 					while (SDL_PollEvent(&e) != 0)
 					{
 						if (e.type == SDL_QUIT)
 						{
 							quit = true;
 						}
+						menuDirty = menuDirty || needsMenuRedraw(e);
+						handleGlobalEvents(e);
 						resultmenu.handleEvent(&e);
 					}
+					gProfiler.endZone();
+
+					menuDirty = menuDirty || resultmenu.isDirty() || gProfiler.isOverlayShown();
+					presentFrame = menuDirty;
+					if (menuDirty)
+					{
+						//Clear screen
+						SDL_SetRenderDrawColor(gRenderer, 0xFF, 0xFF, 0xFF, 0xFF);
+						SDL_RenderClear(gRenderer);
+
+						//Render final score and winner
+						gProfiler.beginZone(PROFILE_ZONE_TEXT);
+						renderScore(match.getScoreCounter(), 250);
 
-					//Clear screen
-					SDL_SetRenderDrawColor(gRenderer, 0xFF, 0xFF, 0xFF, 0xFF);
-					SDL_RenderClear(gRenderer);
+						winnerText.setValue(match.getWinner());
+						winnerText.renderCentered(gTextAtlas, SCREEN_WIDTH / 2, 300, textColor);
 
-					scoreCounter.render();
-					resultmenu.render();
+						resultmenu.render();
+						gProfiler.endZone();
+					}
 				}
 
-				//Update screen
-				SDL_RenderPresent(gRenderer);
+				if (presentFrame)
+				{
+					if (gProfiler.isOverlayShown())
+					{
+						renderProfiler(gProfiler);
+					}
+
+					//Update screen
+					gProfiler.beginZone(PROFILE_ZONE_PRESENT);
+					SDL_RenderPresent(gRenderer);
+					gProfiler.endZone();
+				}
+				menuDirty = false;
+				gProfiler.endFrame();
 				++countedFrames;
 			}
 		}
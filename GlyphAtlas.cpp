@@ -0,0 +1,228 @@
+#include "GlyphAtlas.h"
+#include <stdio.h>
+#include "TraceRecorder.h"
+#include "Profiler.h"
+#include "AllocationTracker.h"
+
+GlyphAtlas::GlyphAtlas()
+{
+	//Initialize
+	mRenderer = NULL;
+	mFont = NULL;
+	mTexture = NULL;
+	mWidth = 0;
+	mHeight = 0;
+	mLineHeight = 0;
+
+	for (int i = 0; i < TOTAL_GLYPHS; ++i)
+	{
+		mGlyphs[i].clip = { 0, 0, 0, 0 };
+		mGlyphs[i].advance = 0;
+	}
+}
+
+GlyphAtlas::~GlyphAtlas()
+{
+	//Deallocate
+	free();
+}
+
+bool GlyphAtlas::build(SDL_Renderer* renderer, TTF_Font* font)
+{
+	TraceScope trace("Build glyph atlas");
+
+	//Get rid of preexisting atlas
+	free();
+
+	mRenderer = renderer;
+	mFont = font;
+	mLineHeight = TTF_FontHeight(font);
+
+	//Rasterize every glyph in white so vertex colors can tint it
+	SDL_Color white = { 0xFF, 0xFF, 0xFF, 0xFF };
+	SDL_Surface* glyphSurfaces[TOTAL_GLYPHS];
+	int penX = 0;
+	int penY = 0;
+	int rowHeight = 0;
+	for (int i = 0; i < TOTAL_GLYPHS; ++i)
+	{
+		Uint16 ch = (Uint16)(FIRST_GLYPH + i);
+		glyphSurfaces[i] = TTF_RenderGlyph_Blended(font, ch, white);
+
+		int advance = 0;
+		TTF_GlyphMetrics(font, ch, NULL, NULL, NULL, NULL, &advance);
+		mGlyphs[i].advance = advance;
+
+		if (glyphSurfaces[i] == NULL)
+		{
+			continue;
+		}
+
+		//Shelf pack the glyph cells row by row
+		if (penX + glyphSurfaces[i]->w > MAX_ATLAS_WIDTH)
+		{
+			penX = 0;
+			penY += rowHeight + 1;
+			rowHeight = 0;
+		}
+		mGlyphs[i].clip = { penX, penY, glyphSurfaces[i]->w, glyphSurfaces[i]->h };
+		penX += glyphSurfaces[i]->w + 1;
+		if (glyphSurfaces[i]->h > rowHeight)
+		{
+			rowHeight = glyphSurfaces[i]->h;
+		}
+		if (penX > mWidth)
+		{
+			mWidth = penX;
+		}
+	}
+	mHeight = penY + rowHeight;
+
+	//Copy the cells into one surface and upload it once
+	SDL_Surface* atlasSurface = SDL_CreateRGBSurfaceWithFormat(0, mWidth, mHeight, 32, SDL_PIXELFORMAT_RGBA32);
+	if (atlasSurface == NULL)
+	{
+		printf("Unable to create glyph atlas surface! SDL Error: %s\n", SDL_GetError());
+	}
+	else
+	{
+		AllocationTracker::countSurface();
+		SDL_FillRect(atlasSurface, NULL, SDL_MapRGBA(atlasSurface->format, 0xFF, 0xFF, 0xFF, 0x00));
+		for (int i = 0; i < TOTAL_GLYPHS; ++i)
+		{
+			if (glyphSurfaces[i] != NULL)
+			{
+				//Copy alpha as is instead of blending it onto the atlas
+				SDL_SetSurfaceBlendMode(glyphSurfaces[i], SDL_BLENDMODE_NONE);
+				SDL_BlitSurface(glyphSurfaces[i], NULL, atlasSurface, &mGlyphs[i].clip);
+			}
+		}
+
+		mTexture = SDL_CreateTextureFromSurface(renderer, atlasSurface);
+		if (mTexture == NULL)
+		{
+			printf("Unable to create glyph atlas texture! SDL Error: %s\n", SDL_GetError());
+		}
+		else
+		{
+			AllocationTracker::countTexture();
+			SDL_SetTextureBlendMode(mTexture, SDL_BLENDMODE_BLEND);
+		}
+
+		SDL_FreeSurface(atlasSurface);
+	}
+
+	//Get rid of glyph surfaces
+	for (int i = 0; i < TOTAL_GLYPHS; ++i)
+	{
+		SDL_FreeSurface(glyphSurfaces[i]);
+	}
+
+	return mTexture != NULL;
+}
+
+void GlyphAtlas::free()
+{
+	//Free texture if it exists
+	if (mTexture != NULL)
+	{
+		SDL_DestroyTexture(mTexture);
+		mTexture = NULL;
+		mWidth = 0;
+		mHeight = 0;
+	}
+}
+
+const GlyphAtlas::Glyph& GlyphAtlas::getGlyph(char c)
+{
+	int index = (unsigned char)c - FIRST_GLYPH;
+	if (index < 0 || index >= TOTAL_GLYPHS)
+	{
+		index = '?' - FIRST_GLYPH;
+	}
+	return mGlyphs[index];
+}
+
+int GlyphAtlas::getKerning(char previous, char current)
+{
+	if (previous == 0 || mFont == NULL)
+	{
+		return 0;
+	}
+	return TTF_GetFontKerningSizeGlyphs(mFont, (Uint16)(unsigned char)previous, (Uint16)(unsigned char)current);
+}
+
+int GlyphAtlas::getTextWidth(const char* text)
+{
+	int width = 0;
+	char previous = 0;
+	for (const char* c = text; *c != '\0'; ++c)
+	{
+		width += getKerning(previous, *c) + getGlyph(*c).advance;
+		previous = *c;
+	}
+	return width;
+}
+
+int GlyphAtlas::getLineHeight()
+{
+	return mLineHeight;
+}
+
+void GlyphAtlas::renderText(int x, int y, const char* text, SDL_Color textColor)
+{
+	if (mTexture == NULL)
+	{
+		return;
+	}
+
+	mVertices.clear();
+
+	float invWidth = 1.f / mWidth;
+	float invHeight = 1.f / mHeight;
+	int penX = x;
+	char previous = 0;
+	for (const char* c = text; *c != '\0'; ++c)
+	{
+		const Glyph& glyph = getGlyph(*c);
+		penX += getKerning(previous, *c);
+		previous = *c;
+
+		const SDL_Rect& clip = glyph.clip;
+		if (clip.w > 0 && clip.h > 0)
+		{
+			float left = (float)penX;
+			float top = (float)y;
+			float right = left + clip.w;
+			float bottom = top + clip.h;
+			float u0 = clip.x * invWidth;
+			float v0 = clip.y * invHeight;
+			float u1 = (clip.x + clip.w) * invWidth;
+			float v1 = (clip.y + clip.h) * invHeight;
+
+			//Four corners of the glyph quad
+			mVertices.push_back({ { left, top }, textColor, { u0, v0 } });
+			mVertices.push_back({ { right, top }, textColor, { u1, v0 } });
+			mVertices.push_back({ { right, bottom }, textColor, { u1, v1 } });
+			mVertices.push_back({ { left, bottom }, textColor, { u0, v1 } });
+		}
+
+		penX += glyph.advance;
+	}
+
+	//Grow the shared quad index list when a longer string shows up
+	int totalQuads = (int)mVertices.size() / 4;
+	for (int quad = (int)mIndices.size() / 6; quad < totalQuads; ++quad)
+	{
+		int first = quad * 4;
+		int quadIndices[6] = { first, first + 1, first + 2, first, first + 2, first + 3 };
+		mIndices.insert(mIndices.end(), quadIndices, quadIndices + 6);
+	}
+
+	//Render the whole string in one call
+	if (totalQuads > 0)
+	{
+		SDL_RenderGeometry(mRenderer, mTexture, mVertices.data(), (int)mVertices.size(), mIndices.data(), totalQuads * 6);
+		gProfiler.countDrawCalls(1);
+	}
+}
@@ -0,0 +1,70 @@
+#pragma once
+#include <SDL.h>
+#include <SDL_ttf.h>
+#include <vector>
+
+//Font glyphs rasterized once into a shared texture, strings are drawn as quads from it
+class GlyphAtlas
+{
+public:
+	//Initializes variables
+	GlyphAtlas();
+
+	//Deallocates memory
+	~GlyphAtlas();
+
+	//Rasterizes the printable glyphs of the font into the atlas texture
+	bool build(SDL_Renderer* renderer, TTF_Font* font);
+
+	//Deallocates atlas texture
+	void free();
+
+	//Gets string dimensions
+	int getTextWidth(const char* text);
+	int getLineHeight();
+
+	//Renders string with its top left corner at given point
+	void renderText(int x, int y, const char* text, SDL_Color textColor);
+
+private:
+	//Printable ASCII range kept in the atlas
+	static const int FIRST_GLYPH = 32;
+	static const int LAST_GLYPH = 126;
+	static const int TOTAL_GLYPHS = LAST_GLYPH - FIRST_GLYPH + 1;
+
+	//Widest row of the atlas texture
+	static const int MAX_ATLAS_WIDTH = 1024;
+
+	struct Glyph
+	{
+		//Glyph cell inside the atlas
+		SDL_Rect clip;
+
+		//Horizontal pen advance
+		int advance;
+	};
+
+	//Finds the glyph of a character, unknown characters fall back to '?'
+	const Glyph& getGlyph(char c);
+
+	//Gets the kerning offset between two characters
+	int getKerning(char previous, char current);
+
+	//Target renderer and source font
+	SDL_Renderer* mRenderer;
+	TTF_Font* mFont;
+
+	//The actual hardware texture
+	SDL_Texture* mTexture;
+
+	//Atlas dimensions
+	int mWidth;
+	int mHeight;
+	int mLineHeight;
+
+	Glyph mGlyphs[TOTAL_GLYPHS];
+
+	//Quad storage reused between strings
+	std::vector<SDL_Vertex> mVertices;
+	std::vector<int> mIndices;
+};
@@ -0,0 +1,413 @@
+//Headless match simulation, runs the game logic without a window, renderer or vsync
+
+//No SDL_main, the headless build doesn't link SDL at all
+#define SDL_MAIN_HANDLED
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <algorithm>
+#include <chrono>
+#include <vector>
+#include "BatchRunner.h"
+#include "AllocationTracker.h"
+#include "BallKernel.h"
+#include "Replay.h"
+#include "Rollback.h"
+#include "TraceRecorder.h"
+
+//Queries the arena's wall grid with a ball's reach box at every position, returns false if a query writes past getItemCount
+//or misses or repeats a wall, the boxes span several cells so walls covering many of them are found more than once
+bool checkWallGrid(const char* name, ArenaHandle arena)
+{
+	const StaticGrid& grid = arena->getWallGrid();
+	const std::vector<SDL_Rect>& walls = arena->getWalls();
+	int maxItems = grid.getItemCount();
+
+	//Guard slots after the promised room catch any write past it
+	const int GUARD_ITEMS = 64;
+	const int GUARD_VALUE = -12345;
+	std::vector<int> items(maxItems + GUARD_ITEMS, GUARD_VALUE);
+
+	int reach = Dot::DOT_MAX_VEL + 1;
+	int totalQueries = 0;
+	for (int y = -reach; y < SCREEN_HEIGHT + reach; y += 7)
+	{
+		for (int x = -reach; x < SCREEN_WIDTH + reach; x += 7)
+		{
+			SDL_Rect box = { x - reach, y - reach, Dot::DOT_WIDTH + 2 * reach, Dot::DOT_HEIGHT + 2 * reach };
+			int totalItems = grid.query(box, items.data());
+			totalQueries += 1;
+
+			bool isValid = totalItems <= maxItems;
+			for (int i = maxItems; i < (int)items.size(); ++i)
+			{
+				isValid = isValid && items[i] == GUARD_VALUE;
+			}
+			for (int i = 1; isValid && i < totalItems; ++i)
+			{
+				isValid = items[i - 1] < items[i];
+			}
+			for (int wall = 0; isValid && wall < (int)walls.size(); ++wall)
+			{
+				if (checkCollision(box, walls[wall]) && !std::binary_search(items.begin(), items.begin() + totalItems, wall))
+				{
+					isValid = false;
+				}
+			}
+			if (!isValid)
+			{
+				printf("FAILED: %s wall grid query at %d, %d gave %d items for %d walls\n", name, x, y, totalItems, maxItems);
+				return false;
+			}
+		}
+	}
+
+	printf("%s wall grid: %d queries, at most %d items each\n", name, totalQueries, maxItems);
+	return true;
+}
+
+//Checks the wall grids of the standard arena and of any arena files given
+//headless gridtest [arena file]...
+int testWallGrids(int argc, char* args[])
+{
+	bool isValid = checkWallGrid("standard", Arena::getStandard());
+	for (int i = 0; i < argc; ++i)
+	{
+		ArenaHandle arena = Arena::load(args[i]);
+		if (arena == NULL)
+		{
+			return 1;
+		}
+		isValid = checkWallGrid(args[i], arena) && isValid;
+	}
+	return isValid ? 0 : 1;
+}
+
+//Plays one match of bots and records it
+//headless record <file> [seed] [player 1 policy] [player 2 policy]
+int recordMatch(int argc, char* args[])
+{
+	Uint64 seed = argc > 1 ? strtoull(args[1], NULL, 10) : (Uint64)time(NULL);
+	int p1Policy = argc > 2 ? atoi(args[2]) : BOT_POLICY_PREDICTIVE;
+	int p2Policy = argc > 3 ? atoi(args[3]) : BOT_POLICY_TRACKING;
+	if (p1Policy < 0 || p1Policy >= BOT_POLICY_TOTAL || p2Policy < 0 || p2Policy >= BOT_POLICY_TOTAL)
+	{
+		printf("Unknown bot policy, use 0 for idle, 1 for tracking or 2 for predictive\n");
+		return 1;
+	}
+
+	Match match;
+	match.setSeed(seed);
+	match.reset();
+
+	ReplayWriter recorder;
+	if (!recorder.open(args[0], match))
+	{
+		return 1;
+	}
+	match.setRecorder(&recorder);
+
+	BotController p1Bot(1, (BotPolicy)p1Policy);
+	BotController p2Bot(2, (BotPolicy)p2Policy);
+	int maxTicks = 10 * 60 * SIM_TICKS_PER_SECOND;
+	while (!match.isOver() && match.getTickCount() < maxTicks)
+	{
+		p1Bot.update(match);
+		p2Bot.update(match);
+		match.tick();
+	}
+	recorder.finish(match);
+
+	printf("Recorded seed %llu: %d ticks, score %d : %d, checksum %08x\n", (unsigned long long)seed, match.getTickCount(),
+		match.getScoreCounter().getScore(1), match.getScoreCounter().getScore(2), match.getChecksum());
+	return 0;
+}
+
+//Replays a recorded match as fast as possible and checks it ends the way it was recorded, then seeks if asked to
+//headless replay <file> [seek tick]
+int playReplay(int argc, char* args[])
+{
+	ReplayPlayer player;
+	if (!player.open(args[0]))
+	{
+		return 1;
+	}
+
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	player.playToEnd();
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	Match& match = player.getMatch();
+	printf("Replayed %d ticks in %.3f s (%.0f ticks/s), score %d : %d, checksum %08x\n", match.getTickCount(), seconds,
+		seconds > 0 ? match.getTickCount() / seconds : 0.0,
+		match.getScoreCounter().getScore(1), match.getScoreCounter().getScore(2), match.getChecksum());
+
+	ReplayReader& reader = player.getReader();
+	if (!reader.hasEnding())
+	{
+		printf("The replay was cut short, it has no ending to check against\n");
+	}
+	else if (reader.getEnding().ticks != match.getTickCount() || reader.getEnding().checksum != match.getChecksum())
+	{
+		printf("FAILED: the replay ended differently than the recorded match\n");
+		return 1;
+	}
+	else
+	{
+		printf("Matches the recorded ending\n");
+	}
+
+	if (argc > 1)
+	{
+		int tick = atoi(args[1]);
+		start = std::chrono::steady_clock::now();
+		bool reached = player.seek(tick);
+		seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+		printf("Seek to tick %d %s in %.3f ms using %d checkpoints, checksum %08x\n", tick, reached ? "done" : "ran past the end",
+			seconds * 1000.0, player.getCheckpointCount(), match.getChecksum());
+	}
+	return 0;
+}
+
+//First of the two loopback ports the UDP netplay test uses
+const int NETPLAY_TEST_PORT = 47800;
+
+//Default seed and player 2 bar speed of the netplay test
+//Two full speed bots keep the ball in play for good, a slower player 2 lets in goals so the match finishes
+const Uint64 NETPLAY_TEST_SEED = 1;
+const int NETPLAY_TEST_BOT_SPEED = 4;
+
+//Gets how many checksums a peer compares over a whole match, one every interval before the last tick
+static int getChecksumTickCount(Match& match)
+{
+	return std::max(match.getTickCount() - 1, 0) / NETPLAY_CHECKSUM_INTERVAL;
+}
+
+//Gets whether both peers finished and compared every checksum of the match
+static bool isNetplayDone(RollbackSession* sessions, Match* matches)
+{
+	for (int i = 0; i < 2; ++i)
+	{
+		if (!sessions[i].isFinished() || sessions[i].getStats().checksumsCompared < getChecksumTickCount(matches[i]))
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+//Plays a match of bots between two rollback sessions over a lagging, lossy link
+//Passes only if the peers never desync, goals are scored and both finish the match
+//headless netplay [transport] [latency ms] [jitter ms] [loss percent] [seed] [player 1 policy] [player 2 policy] [player 2 speed]
+int playNetplay(int argc, char* args[])
+{
+	int transportType = argc > 0 ? atoi(args[0]) : 0;
+	double latency = argc > 1 ? atof(args[1]) / 1000.0 : 0.05;
+	double jitter = argc > 2 ? atof(args[2]) / 1000.0 : 0.01;
+	int lossPercent = argc > 3 ? atoi(args[3]) : 5;
+	Uint64 seed = argc > 4 ? strtoull(args[4], NULL, 10) : NETPLAY_TEST_SEED;
+	int policies[2] = { argc > 5 ? atoi(args[5]) : BOT_POLICY_PREDICTIVE, argc > 6 ? atoi(args[6]) : BOT_POLICY_TRACKING };
+	int botSpeed = argc > 7 ? atoi(args[7]) : NETPLAY_TEST_BOT_SPEED;
+	for (int i = 0; i < 2; ++i)
+	{
+		if (policies[i] < 0 || policies[i] >= BOT_POLICY_TOTAL)
+		{
+			printf("Unknown bot policy, use 0 for idle, 1 for tracking or 2 for predictive\n");
+			return 1;
+		}
+	}
+
+	//Rollbacks are traced, so the thread's trace buffer is made now rather than on the first one
+	TraceRecorder::setThreadName("Netplay");
+
+	//Both ends of the link, in this process or on two loopback ports
+	LocalTransport localLinks[2];
+	LocalTransport::connect(localLinks[0], localLinks[1]);
+	UdpTransport udpLinks[2];
+	NetTransport* links[2] = { &localLinks[0], &localLinks[1] };
+	if (transportType == 1)
+	{
+		if (!udpLinks[0].open(NETPLAY_TEST_PORT, "127.0.0.1", NETPLAY_TEST_PORT + 1) ||
+			!udpLinks[1].open(NETPLAY_TEST_PORT + 1, "127.0.0.1", NETPLAY_TEST_PORT))
+		{
+			return 1;
+		}
+		links[0] = &udpLinks[0];
+		links[1] = &udpLinks[1];
+	}
+
+	LaggyTransport laggyLinks[2] = { LaggyTransport(links[0], seed), LaggyTransport(links[1], seed + 1) };
+	Match matches[2];
+	RollbackSession sessions[2];
+	BotController bots[2] = { BotController(1, (BotPolicy)policies[0]), BotController(2, (BotPolicy)policies[1]) };
+	bots[1].setMaxSpeed(botSpeed);
+	for (int i = 0; i < 2; ++i)
+	{
+		laggyLinks[i].setLag(latency, jitter, lossPercent);
+		matches[i].setSeed(seed);
+		matches[i].reset();
+		sessions[i].start(&matches[i], i + 1, &laggyLinks[i], (Uint32)seed);
+	}
+	printf("Netplay over %s, %.0f ms latency, %.0f ms jitter, %d%% loss, seed %llu\n", transportType == 1 ? "loopback UDP" : "an in-process link",
+		latency * 1000.0, jitter * 1000.0, lossPercent, (unsigned long long)seed);
+
+	//Both peers run a frame each per tick of simulated time, cut off like a batch match
+	//Finished peers keep running until the last checksums got across, desynced ones can end up waiting on each other for good, so they stop at once
+	int maxTicks = 10 * 60 * SIM_TICKS_PER_SECOND;
+	int maxFrames = 2 * maxTicks;
+	int frame = 0;
+	AllocationCounts steadyStart = AllocationCounts();
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	while (!isNetplayDone(sessions, matches) && std::min(sessions[0].getTick(), sessions[1].getTick()) < maxTicks &&
+		frame < maxFrames && !sessions[0].isDesynced() && !sessions[1].isDesynced())
+	{
+		for (int i = 0; i < 2; ++i)
+		{
+			laggyLinks[i].advance(SIM_TICK_SECONDS);
+			bots[i].update(matches[i]);
+			sessions[i].advance();
+		}
+		frame += 1;
+
+		//Like a batch match, nothing should allocate after the first tick
+		if (frame == 1)
+		{
+			steadyStart = AllocationTracker::getThreadCounts();
+		}
+	}
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	for (int i = 0; i < 2; ++i)
+	{
+		RollbackStats& stats = sessions[i].getStats();
+		printf("Peer %d: tick %d, score %d : %d, %d rollbacks replaying %lld ticks, longest %d ticks, slowest %.3f ms\n", i + 1, matches[i].getTickCount(),
+			matches[i].getScoreCounter().getScore(1), matches[i].getScoreCounter().getScore(2),
+			stats.rollbacks, stats.resimulatedTicks, stats.longestRollback, stats.slowestRollbackSeconds * 1000.0);
+		printf("        %d stalled frames, %d packets sent, %d lost, %d received, %d checksums compared\n", stats.stalledFrames,
+			laggyLinks[i].getSentCount(), laggyLinks[i].getLostCount(), stats.packetsReceived, stats.checksumsCompared);
+	}
+	printf("%d frames in %.3f s\n", frame, seconds);
+
+	long long steadyAllocations = (AllocationTracker::getThreadCounts() - steadyStart).allocations;
+	if (AllocationTracker::isEnabled())
+	{
+		printf("Steady state allocations: %lld\n", steadyAllocations);
+		if (steadyAllocations > 0)
+		{
+			return 1;
+		}
+	}
+
+	//Finished peers have to agree on how the match ended, cut off ones on every checksum they compared
+	bool isFinished = sessions[0].isFinished() && sessions[1].isFinished();
+	if (sessions[0].isDesynced() || sessions[1].isDesynced() ||
+		(isFinished && sessions[0].getFinalChecksum() != sessions[1].getFinalChecksum()))
+	{
+		printf("FAILED: the peers desynced\n");
+		return 1;
+	}
+
+	//Agreeing on a match where the ball never went in proves little, it has to have been reset and finished
+	int goals = matches[0].getScoreCounter().getScore(1) + matches[0].getScoreCounter().getScore(2);
+	if (goals == 0 || !isFinished)
+	{
+		printf("FAILED: the peers agreed, but %s\n", goals == 0 ? "no goal was scored" : "the match was cut off before it finished");
+		return 1;
+	}
+
+	//Every checksum tick has to be compared, so a desync anywhere in the match is caught where it happened
+	for (int i = 0; i < 2; ++i)
+	{
+		if (sessions[i].getStats().checksumsCompared != getChecksumTickCount(matches[i]))
+		{
+			printf("FAILED: peer %d compared %d of %d checksums\n", i + 1, sessions[i].getStats().checksumsCompared, getChecksumTickCount(matches[i]));
+			return 1;
+		}
+	}
+	printf("Both peers finished with checksum %08x\n", sessions[0].getFinalChecksum());
+	return 0;
+}
+
+int main(int argc, char* args[])
+{
+	if (argc > 2 && strcmp(args[1], "record") == 0)
+	{
+		return recordMatch(argc - 2, args + 2);
+	}
+	if (argc > 2 && strcmp(args[1], "replay") == 0)
+	{
+		return playReplay(argc - 2, args + 2);
+	}
+	if (argc > 1 && strcmp(args[1], "gridtest") == 0)
+	{
+		return testWallGrids(argc - 2, args + 2);
+	}
+	if (argc > 1 && strcmp(args[1], "netplay") == 0)
+	{
+		return playNetplay(argc - 2, args + 2);
+	}
+
+	//headless [matches] [threads] [player 1 policy] [player 2 policy] [seed] [extra balls] [ball kernel] [arena file]
+	int totalMatches = argc > 1 ? atoi(args[1]) : 1000;
+	int totalThreads = argc > 2 ? atoi(args[2]) : 0;
+	int p1Policy = argc > 3 ? atoi(args[3]) : BOT_POLICY_PREDICTIVE;
+	int p2Policy = argc > 4 ? atoi(args[4]) : BOT_POLICY_IDLE;
+	if (p1Policy < 0 || p1Policy >= BOT_POLICY_TOTAL || p2Policy < 0 || p2Policy >= BOT_POLICY_TOTAL)
+	{
+		printf("Unknown bot policy, use 0 for idle, 1 for tracking or 2 for predictive\n");
+		return 1;
+	}
+
+	//Match i plays with seed + i, pass the printed seed to rerun the same batch
+	Uint64 seed = argc > 5 ? strtoull(args[5], NULL, 10) : (Uint64)time(NULL);
+	printf("Seed: %llu\n", (unsigned long long)seed);
+
+	//Multiball stress, the kernel can be forced down to 1 for SSE2 or 0 for scalar to compare them
+	int extraBalls = argc > 6 ? atoi(args[6]) : 0;
+	if (argc > 7)
+	{
+		setBallKernel((BallKernel)atoi(args[7]));
+	}
+	if (extraBalls > 0)
+	{
+		printf("Extra balls: %d, ball kernel: %s\n", extraBalls, getBallKernelName(getBallKernel()));
+	}
+
+	//Loaded once, every match of the batch plays on the same copy
+	ArenaHandle arena = Arena::getStandard();
+	if (argc > 8)
+	{
+		arena = Arena::load(args[8]);
+		if (arena == NULL)
+		{
+			return 1;
+		}
+		printf("Arena: %s, %d walls\n", args[8], (int)arena->getWalls().size());
+	}
+
+	MatchConfig config = MatchConfig();
+	config.p1Policy = (BotPolicy)p1Policy;
+	config.p2Policy = (BotPolicy)p2Policy;
+	config.speedCurve = DEFAULT_SPEED_CURVE;
+	config.extraBalls = extraBalls;
+	config.arena = arena;
+	config.maxTicks = 10 * 60 * SIM_TICKS_PER_SECOND;
+	std::vector<MatchConfig> configs(totalMatches, config);
+	for (int i = 0; i < totalMatches; ++i)
+	{
+		configs[i].seed = seed + i;
+	}
+
+	BatchSummary summary = runBatch(configs, totalThreads);
+	summary.print();
+
+	//Built with TRACK_ALLOCATIONS the run doubles as a check that ticks stay off the heap
+	if (AllocationTracker::isEnabled() && summary.steadyAllocations > 0)
+	{
+		printf("FAILED: matches allocated after their first tick\n");
+		return 1;
+	}
+
+	return 0;
+}
@@ -0,0 +1,115 @@
+#include "HudText.h"
+#include <charconv>
+
+//Copies a string into the buffer, as much of it as fits
+static char* appendText(char* cursor, char* end, const char* text)
+{
+	while (*text != '\0' && cursor < end)
+	{
+		*cursor++ = *text++;
+	}
+	return cursor;
+}
+
+//Writes a number into the buffer, or a single '?' when it doesn't fit, since to_chars leaves the buffer undefined then
+static char* appendNumber(char* cursor, char* end, int value)
+{
+	std::to_chars_result result = std::to_chars(cursor, end, value);
+	if (result.ec == std::errc())
+	{
+		return result.ptr;
+	}
+	return appendText(cursor, end, "?");
+}
+
+HudText::HudText(const char* prefix, const char* separator, const char* suffix)
+{
+	mPrefix = prefix;
+	mSeparator = separator;
+	mSuffix = suffix;
+
+	mFirst = 0;
+	mSecond = 0;
+	mHasSecond = false;
+
+	mText[0] = '\0';
+	mStale = true;
+	mWidth = 0;
+	mWidthStale = true;
+}
+
+void HudText::setValue(int value)
+{
+	if (value != mFirst || mHasSecond)
+	{
+		mFirst = value;
+		mHasSecond = false;
+		mStale = true;
+	}
+}
+
+void HudText::setValues(int first, int second)
+{
+	if (first != mFirst || second != mSecond || !mHasSecond)
+	{
+		mFirst = first;
+		mSecond = second;
+		mHasSecond = true;
+		mStale = true;
+	}
+}
+
+void HudText::format()
+{
+	//Keep one character for the terminator, numbers that don't fit show as '?'
+	char* cursor = mText;
+	char* end = mText + MAX_TEXT_LENGTH - 1;
+
+	cursor = appendText(cursor, end, mPrefix);
+	cursor = appendNumber(cursor, end, mFirst);
+	if (mHasSecond)
+	{
+		cursor = appendText(cursor, end, mSeparator);
+		cursor = appendNumber(cursor, end, mSecond);
+	}
+	cursor = appendText(cursor, end, mSuffix);
+	*cursor = '\0';
+
+	mStale = false;
+	mWidthStale = true;
+}
+
+const char* HudText::getText()
+{
+	if (mStale)
+	{
+		format();
+	}
+	return mText;
+}
+
+int HudText::getWidth(GlyphAtlas& atlas)
+{
+	const char* text = getText();
+	if (mWidthStale)
+	{
+		mWidth = atlas.getTextWidth(text);
+		mWidthStale = false;
+	}
+	return mWidth;
+}
+
+void HudText::render(GlyphAtlas& atlas, int x, int y, SDL_Color textColor)
+{
+	atlas.renderText(x, y, getText(), textColor);
+}
+
+void HudText::renderRightAligned(GlyphAtlas& atlas, int right, int y, SDL_Color textColor)
+{
+	render(atlas, right - getWidth(atlas), y, textColor);
+}
+
+void HudText::renderCentered(GlyphAtlas& atlas, int centerX, int y, SDL_Color textColor)
+{
+	render(atlas, centerX - getWidth(atlas) / 2, y, textColor);
+}
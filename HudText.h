@@ -0,0 +1,52 @@
+#pragma once
+#include <SDL.h>
+#include "GlyphAtlas.h"
+
+//HUD line showing one or two numbers between fixed strings, like "12s" or "2 : 1"
+//The text lives in a fixed buffer and is formatted and measured only when a number changes
+class HudText
+{
+public:
+	//Initializes the fixed parts of the line, the strings must outlive the widget
+	HudText(const char* prefix = "", const char* separator = "", const char* suffix = "");
+
+	//Sets the shown numbers, the second one is shown only if given
+	void setValue(int value);
+	void setValues(int first, int second);
+
+	//Gets the formatted line
+	const char* getText();
+
+	//Gets the width of the line in the atlas font
+	int getWidth(GlyphAtlas& atlas);
+
+	//Renders the line with its top left corner, top right corner or top center at given point
+	void render(GlyphAtlas& atlas, int x, int y, SDL_Color textColor);
+	void renderRightAligned(GlyphAtlas& atlas, int right, int y, SDL_Color textColor);
+	void renderCentered(GlyphAtlas& atlas, int centerX, int y, SDL_Color textColor);
+
+private:
+	//Longest line including the terminator
+	static const int MAX_TEXT_LENGTH = 64;
+
+	//Writes the line into the buffer
+	void format();
+
+	//Fixed parts of the line
+	const char* mPrefix;
+	const char* mSeparator;
+	const char* mSuffix;
+
+	//Shown numbers
+	int mFirst;
+	int mSecond;
+	bool mHasSecond;
+
+	//Formatted line, stale until the next format
+	char mText[MAX_TEXT_LENGTH];
+	bool mStale;
+
+	//Width of the line, measured when it's first needed after a format
+	int mWidth;
+	bool mWidthStale;
+};
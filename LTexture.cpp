@@ -0,0 +1,239 @@
+#include "LTexture.h"
+#include <stdio.h>
+#include "TraceRecorder.h"
+#include "Profiler.h"
+#include "AllocationTracker.h"
+
+LTexture::LTexture()
+{
+	//Initialize
+	mTexture = NULL;
+	mWidth = 0;
+	mHeight = 0;
+	mRegion = { 0, 0, 0, 0 };
+}
+
+LTexture::~LTexture()
+{
+	//Deallocate
+	free();
+}
+
+bool LTexture::loadFromFile(std::string path)
+{
+	TraceScope trace("Decode image");
+
+	//Get rid of preexisting texture
+	free();
+
+	//Load image at specified path
+	SDL_Surface* loadedSurface = IMG_Load(path.c_str());
+	if (loadedSurface == NULL)
+	{
+		printf("Unable to load image %s! SDL_image Error: %s\n", path.c_str(), IMG_GetError());
+		return false;
+	}
+
+	//Color key image
+	SDL_SetColorKey(loadedSurface, SDL_TRUE, SDL_MapRGB(loadedSurface->format, 0, 0xFF, 0xFF));
+
+	//Create texture from surface pixels
+	bool success = loadFromSurface(loadedSurface);
+	if (!success)
+	{
+		printf("Unable to create texture from %s!\n", path.c_str());
+	}
+
+	//Get rid of old loaded surface
+	SDL_FreeSurface(loadedSurface);
+	return success;
+}
+
+bool LTexture::loadFromRenderedText(std::string textureText, SDL_Color textColor)
+{
+	TraceScope trace("Render text texture");
+
+	//Get rid of preexisting texture
+	free();
+
+	//Render text surface
+	SDL_Surface* textSurface = TTF_RenderText_Solid(gFont, textureText.c_str(), textColor);
+	if (textSurface == NULL)
+	{
+		printf("Unable to render text surface! SDL_ttf Error: %s\n", TTF_GetError());
+	}
+	else
+	{
+		//Create texture from surface pixels
+		mTexture = SDL_CreateTextureFromSurface(gRenderer, textSurface);
+		if (mTexture == NULL)
+		{
+			printf("Unable to create texture from rendered text! SDL Error: %s\n", SDL_GetError());
+		}
+		else
+		{
+			AllocationTracker::countTexture();
+
+			//Get image dimensions
+			mWidth = textSurface->w;
+			mHeight = textSurface->h;
+			mRegion = { 0, 0, mWidth, mHeight };
+		}
+
+		//Get rid of old surface
+		SDL_FreeSurface(textSurface);
+	}
+
+	//Return success
+	return mTexture != NULL;
+}
+
+bool LTexture::loadFromSurface(SDL_Surface* surface)
+{
+	//Get rid of preexisting texture
+	free();
+
+	mTexture = SDL_CreateTextureFromSurface(gRenderer, surface);
+	if (mTexture == NULL)
+	{
+		printf("Unable to create texture from surface! SDL Error: %s\n", SDL_GetError());
+		return false;
+	}
+	AllocationTracker::countTexture();
+
+	//Get image dimensions
+	mWidth = surface->w;
+	mHeight = surface->h;
+	mRegion = { 0, 0, mWidth, mHeight };
+	return true;
+}
+
+bool LTexture::loadFromPixels(const void* pixels, int width, int height, int pitch, Uint32 format)
+{
+	//Get rid of preexisting texture
+	free();
+
+	mTexture = SDL_CreateTexture(gRenderer, format, SDL_TEXTUREACCESS_STATIC, width, height);
+	if (mTexture == NULL)
+	{
+		printf("Unable to create texture! SDL Error: %s\n", SDL_GetError());
+		return false;
+	}
+	AllocationTracker::countTexture();
+	if (SDL_UpdateTexture(mTexture, NULL, pixels, pitch) != 0)
+	{
+		printf("Unable to upload texture pixels! SDL Error: %s\n", SDL_GetError());
+		free();
+		return false;
+	}
+	SDL_SetTextureBlendMode(mTexture, SDL_BLENDMODE_BLEND);
+
+	//Get image dimensions
+	mWidth = width;
+	mHeight = height;
+	mRegion = { 0, 0, mWidth, mHeight };
+	return true;
+}
+
+void LTexture::setAtlasRegion(TextureHandle page, const SDL_Rect& region)
+{
+	//Get rid of preexisting texture
+	free();
+
+	mAtlasPage = page;
+	mTexture = page->getTexture();
+	mWidth = region.w;
+	mHeight = region.h;
+	mRegion = region;
+}
+
+void LTexture::free()
+{
+	//Let go of the atlas page, it frees itself once unused
+	if (mAtlasPage)
+	{
+		mAtlasPage.reset();
+		mTexture = NULL;
+	}
+
+	//Free texture if it exists
+	if (mTexture != NULL)
+	{
+		SDL_DestroyTexture(mTexture);
+		mTexture = NULL;
+	}
+	mWidth = 0;
+	mHeight = 0;
+	mRegion = { 0, 0, 0, 0 };
+}
+
+void LTexture::setColor(Uint8 red, Uint8 green, Uint8 blue)
+{
+	//Modulate texture rgb
+	SDL_SetTextureColorMod(mTexture, red, green, blue);
+}
+
+void LTexture::setBlendMode(SDL_BlendMode blending)
+{
+	//Set blending function
+	SDL_SetTextureBlendMode(mTexture, blending);
+}
+
+void LTexture::setAlpha(Uint8 alpha)
+{
+	//Modulate texture alpha
+	SDL_SetTextureAlphaMod(mTexture, alpha);
+}
+
+void LTexture::render(int x, int y, SDL_Rect* clip, double angle, SDL_Point* center, SDL_RendererFlip flip)
+{
+	//Set rendering space and render to screen
+	SDL_Rect renderQuad = { x, y, mWidth, mHeight };
+
+	//Clips are relative to the image, wherever it is in the hardware texture
+	SDL_Rect source = mRegion;
+	if (clip != NULL)
+	{
+		source = { mRegion.x + clip->x, mRegion.y + clip->y, clip->w, clip->h };
+		renderQuad.w = clip->w;
+		renderQuad.h = clip->h;
+	}
+
+	//Render to screen
+	SDL_RenderCopyEx(gRenderer, mTexture, &source, &renderQuad, angle, center, flip);
+	gProfiler.countDrawCalls(1);
+}
+
+int LTexture::getWidth()
+{
+	return mWidth;
+}
+
+SDL_Texture* LTexture::getTexture()
+{
+	return mTexture;
+}
+
+void LTexture::getTextureSize(int& width, int& height)
+{
+	if (mAtlasPage)
+	{
+		width = mAtlasPage->getWidth();
+		height = mAtlasPage->getHeight();
+	}
+	else
+	{
+		width = mWidth;
+		height = mHeight;
+	}
+}
+
+SDL_Rect LTexture::getRegion()
+{
+	return mRegion;
+}
+
+int LTexture::getHeight()
+{
+	return mHeight;
+}
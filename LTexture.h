@@ -0,0 +1,83 @@
+#pragma once
+#include <SDL.h>
+#include <SDL_image.h>
+#include <SDL_ttf.h>
+#include <string>
+#include <memory>
+
+//The window renderer
+extern SDL_Renderer* gRenderer;
+
+//Globally used font
+extern TTF_Font* gFont;
+
+class LTexture;
+
+//Shared, reference counted texture handle
+typedef std::shared_ptr<LTexture> TextureHandle;
+
+//Texture wrapper class
+//A texture either owns its hardware texture or shows a region of an atlas page
+class LTexture
+{
+public:
+	//Initializes variables
+	LTexture();
+
+	//Deallocates memory
+	~LTexture();
+
+	//Loads image at specified path
+	bool loadFromFile(std::string path);
+
+	//Creates image from font string
+	bool loadFromRenderedText(std::string textureText, SDL_Color textColor);
+
+	//Creates image from surface pixels
+	bool loadFromSurface(SDL_Surface* surface);
+
+	//Creates image from raw pixels, uploaded as they are without conversion
+	bool loadFromPixels(const void* pixels, int width, int height, int pitch, Uint32 format);
+
+	//Makes this texture show a region of an atlas page, the page stays alive as long as this texture
+	//Color, alpha and blending are shared with everything else on the page
+	void setAtlasRegion(TextureHandle page, const SDL_Rect& region);
+
+	//Deallocates texture
+	void free();
+
+	//Set color modulation
+	void setColor(Uint8 red, Uint8 green, Uint8 blue);
+
+	//Set blending
+	void setBlendMode(SDL_BlendMode blending);
+
+	//Set alpha modulation
+	void setAlpha(Uint8 alpha);
+
+	//Renders texture at given point
+	void render(int x, int y, SDL_Rect* clip = NULL, double angle = 0.0, SDL_Point* center = NULL, SDL_RendererFlip flip = SDL_FLIP_NONE);
+
+	//Gets image dimensions
+	int getWidth();
+	int getHeight();
+
+	//Gets the hardware texture, its size and the region of it this texture covers, for batching
+	SDL_Texture* getTexture();
+	void getTextureSize(int& width, int& height);
+	SDL_Rect getRegion();
+
+private:
+	//The actual hardware texture
+	SDL_Texture* mTexture;
+
+	//Image dimensions
+	int mWidth;
+	int mHeight;
+
+	//The atlas page the hardware texture belongs to, none if owned
+	TextureHandle mAtlasPage;
+
+	//Where the image is in the hardware texture
+	SDL_Rect mRegion;
+};
@@ -0,0 +1,411 @@
+#include "Match.h"
+#include <stdlib.h>
+#include <algorithm>
+#include "Replay.h"
+
+Serve drawServe(Random& random, const SpeedCurve& speedCurve, int stage, int higherScorePlayer)
+{
+	int speedRange = std::min(speedCurve.baseRange + speedCurve.rangePerStage * stage, speedCurve.maxRange);
+
+	Serve serve;
+	serve.velX = random.below(speedRange) + speedCurve.minSpeed;
+	serve.velY = random.below(speedRange) + speedCurve.minSpeed;
+
+	//Player 1 defends the left side, player 2 the right
+	switch (higherScorePlayer)
+	{
+	case 1:
+		serve.velX *= -1;
+		break;
+	case 2:
+		break;
+	default:
+		if (random.coinFlip()) serve.velX *= -1;
+		break;
+	}
+
+	if (random.coinFlip()) serve.velY *= -1;
+	return serve;
+}
+
+Match::Match()
+{
+	mCountdownTicks = 0;
+	mTickCount = 0;
+	mSpeedCurve = DEFAULT_SPEED_CURVE;
+	mProfiler = NULL;
+	mRecorder = NULL;
+	setArena(Arena::getStandard());
+}
+
+void Match::setArena(ArenaHandle arena)
+{
+	mArena = arena;
+	int totalBalls = std::max(mEntities.getBallCount(), 1);
+	mEntities.clear();
+	mEntities.resizeBalls(totalBalls);
+
+	const std::vector<BarSlot>& barSlots = mArena->getBarSlots();
+	for (size_t i = 0; i < barSlots.size(); ++i)
+	{
+		const BarSlot& slot = barSlots[i];
+		mEntities.addBar(slot.player, slot.barId, slot.box.x, slot.box.y, slot.box.w, slot.box.h);
+	}
+
+	const std::vector<GoalArea>& goals = mArena->getGoals();
+	for (size_t i = 0; i < goals.size(); ++i)
+	{
+		const GoalArea& goal = goals[i];
+		mEntities.addGoal(goal.player, goal.box.x, goal.box.y, goal.box.w, goal.box.h);
+	}
+
+	const std::vector<SDL_Rect>& walls = mArena->getWalls();
+	for (size_t i = 0; i < walls.size(); ++i)
+	{
+		mEntities.addWall(walls[i].x, walls[i].y, walls[i].w, walls[i].h);
+	}
+
+	//Bars are written every tick, the walls never change
+	int totalBars = mEntities.getBarCount();
+	const std::vector<Obstacle>& wallObstacles = mArena->getWallObstacles();
+	mObstacles.resize(totalBars);
+	mObstacles.insert(mObstacles.end(), wallObstacles.begin(), wallObstacles.end());
+
+	//Both grids write each obstacle at most once per query, so one slot per obstacle is always enough
+	mHitMasks.resize(1);
+	mCandidates.resize(mObstacles.size());
+	mBarGrid.reset(SCREEN_WIDTH, SCREEN_HEIGHT, BAR_CELL_SIZE, totalBars);
+	reset();
+}
+
+ArenaHandle Match::getArena()
+{
+	return mArena;
+}
+
+void Match::setSpeedCurve(const SpeedCurve& speedCurve)
+{
+	mSpeedCurve = speedCurve;
+}
+
+SpeedCurve Match::getSpeedCurve()
+{
+	return mSpeedCurve;
+}
+
+void Match::setSeed(Uint64 seed)
+{
+	mRandom.seed(seed);
+}
+
+Uint64 Match::getSeed()
+{
+	return mRandom.getSeed();
+}
+
+void Match::setExtraBalls(int totalExtraBalls)
+{
+	mEntities.resizeBalls(1 + std::max(totalExtraBalls, 0));
+}
+
+int Match::getExtraBalls()
+{
+	return mEntities.getBallCount() - 1;
+}
+
+void Match::setProfiler(Profiler* profiler)
+{
+	mProfiler = profiler;
+}
+
+void Match::setRecorder(ReplayWriter* recorder)
+{
+	mRecorder = recorder;
+}
+
+void Match::reset()
+{
+	const std::vector<BarSlot>& barSlots = mArena->getBarSlots();
+	for (int i = 0; i < getBarCount(); ++i)
+	{
+		PBar bar = getBar(i);
+		bar.setPos(barSlots[i].box.x, barSlots[i].box.y);
+		bar.reset();
+	}
+
+	mScoreCounter.reset();
+	mTickCount = 0;
+	mStats = MatchStats();
+	mRallyHits = 0;
+	launchExtraBalls();
+	serve();
+}
+
+void Match::handleEvent(SDL_Event& e)
+{
+	for (int i = 0; i < getBarCount(); ++i)
+	{
+		getBar(i).handleEvent(e);
+	}
+}
+
+void Match::setBarMode(int player, BarMode mode)
+{
+	int totalBars = mEntities.getBarCount();
+	for (int i = 0; i < totalBars; ++i)
+	{
+		if (mEntities.barPlayer[i] != player)
+		{
+			continue;
+		}
+
+		bool isEnabled = mode == BAR_MODE_BOTH || (mEntities.barId[i] == 1 ? mode == BAR_MODE_GOAL_BAR : mode == BAR_MODE_FRONT_BAR);
+		mEntities.barDisabled[i] = isEnabled ? 0 : 1;
+	}
+}
+
+void Match::tick()
+{
+	if (isOver())
+	{
+		return;
+	}
+	if (mRecorder != NULL)
+	{
+		mRecorder->recordTick(mTickCount, mEntities);
+	}
+	mTickCount += 1;
+
+	//Serve once the countdown runs out
+	if (mCountdownTicks > 0)
+	{
+		mCountdownTicks -= 1;
+		if (mCountdownTicks == 0)
+		{
+			getDot().setIsRooling(true);
+		}
+	}
+
+	//Move the bars, then sweep the dot against where they went
+	mEntities.moveBars();
+	int totalBars = mEntities.gatherBarObstacles(mObstacles.data(), (int)mObstacles.size());
+	{
+		ProfileScope scope(mProfiler, PROFILE_ZONE_COLLISION);
+		updateBarGrid(totalBars);
+		ObstacleIndex index = { &mBarGrid, &mArena->getWallGrid() };
+		mEntities.moveBalls(1, mObstacles.data(), index, mCandidates.data(), mHitMasks.data());
+		mEntities.moveFreeBalls(1, mObstacles.data(), index, mCandidates.data());
+	}
+
+	//The bars are the first obstacles
+	Uint32 hitMask = mHitMasks[0];
+	for (int i = 0; i < totalBars; ++i)
+	{
+		if (hitMask & (1u << i))
+		{
+			mRallyHits += 1;
+		}
+	}
+
+	//A goal scores for the player it doesn't belong to
+	int stage = mScoreCounter.getStage();
+	int goal = mEntities.findGoal(0);
+	if (goal >= 0) {
+		mScoreCounter.plusScore(mEntities.goalPlayer[goal] == 1 ? 2 : 1);
+		mStats.points += 1;
+		mStats.barHits += mRallyHits;
+		mStats.longestRally = std::max(mStats.longestRally, mRallyHits);
+		mStats.goalsPerStage[std::min(stage, MAX_TRACKED_STAGES) - 1] += 1;
+		mRallyHits = 0;
+		serve();
+	}
+}
+
+void Match::finishStats()
+{
+	//A rally only starts once the ball is served
+	if (isOver() || mCountdownTicks > 0)
+	{
+		return;
+	}
+	mStats.cutOffRallies += 1;
+	mStats.barHits += mRallyHits;
+	mStats.longestRally = std::max(mStats.longestRally, mRallyHits);
+	mRallyHits = 0;
+}
+
+void Match::saveSnapshot(MatchSnapshot& snapshot)
+{
+	snapshot.ballX = mEntities.ballX;
+	snapshot.ballY = mEntities.ballY;
+	snapshot.ballPrevX = mEntities.ballPrevX;
+	snapshot.ballPrevY = mEntities.ballPrevY;
+	snapshot.ballVelX = mEntities.ballVelX;
+	snapshot.ballVelY = mEntities.ballVelY;
+	snapshot.ballRolling = mEntities.ballRolling;
+	snapshot.barX = mEntities.barX;
+	snapshot.barY = mEntities.barY;
+	snapshot.barPrevX = mEntities.barPrevX;
+	snapshot.barPrevY = mEntities.barPrevY;
+	snapshot.barVelX = mEntities.barVelX;
+	snapshot.barVelY = mEntities.barVelY;
+	snapshot.barDisabled = mEntities.barDisabled;
+
+	snapshot.scoreCounter = mScoreCounter;
+	snapshot.countdownTicks = mCountdownTicks;
+	snapshot.tickCount = mTickCount;
+	snapshot.random = mRandom;
+	snapshot.stats = mStats;
+	snapshot.rallyHits = mRallyHits;
+}
+
+void Match::loadSnapshot(const MatchSnapshot& snapshot)
+{
+	//Same sizes, so these are plain copies
+	mEntities.ballX = snapshot.ballX;
+	mEntities.ballY = snapshot.ballY;
+	mEntities.ballPrevX = snapshot.ballPrevX;
+	mEntities.ballPrevY = snapshot.ballPrevY;
+	mEntities.ballVelX = snapshot.ballVelX;
+	mEntities.ballVelY = snapshot.ballVelY;
+	mEntities.ballRolling = snapshot.ballRolling;
+	mEntities.barX = snapshot.barX;
+	mEntities.barY = snapshot.barY;
+	mEntities.barPrevX = snapshot.barPrevX;
+	mEntities.barPrevY = snapshot.barPrevY;
+	mEntities.barVelX = snapshot.barVelX;
+	mEntities.barVelY = snapshot.barVelY;
+	mEntities.barDisabled = snapshot.barDisabled;
+
+	mScoreCounter = snapshot.scoreCounter;
+	mCountdownTicks = snapshot.countdownTicks;
+	mTickCount = snapshot.tickCount;
+	mRandom = snapshot.random;
+	mStats = snapshot.stats;
+	mRallyHits = snapshot.rallyHits;
+}
+
+//Mixes a value into an FNV-1a hash
+static Uint32 mixHash(Uint32 hash, int value)
+{
+	for (int i = 0; i < 4; ++i)
+	{
+		hash = (hash ^ ((Uint32)value >> (i * 8) & 0xFF)) * 16777619u;
+	}
+	return hash;
+}
+
+Uint32 Match::getChecksum()
+{
+	Uint32 hash = 2166136261u;
+	hash = mixHash(hash, mTickCount);
+	hash = mixHash(hash, mCountdownTicks);
+	hash = mixHash(hash, mScoreCounter.getScore(1));
+	hash = mixHash(hash, mScoreCounter.getScore(2));
+	for (int i = 0; i < mEntities.getBallCount(); ++i)
+	{
+		hash = mixHash(hash, mEntities.ballX[i]);
+		hash = mixHash(hash, mEntities.ballY[i]);
+		hash = mixHash(hash, mEntities.ballVelX[i]);
+		hash = mixHash(hash, mEntities.ballVelY[i]);
+	}
+	for (int i = 0; i < mEntities.getBarCount(); ++i)
+	{
+		hash = mixHash(hash, mEntities.barX[i]);
+		hash = mixHash(hash, mEntities.barY[i]);
+		hash = mixHash(hash, mEntities.barDisabled[i]);
+	}
+	return hash;
+}
+
+void Match::serve()
+{
+	Serve serve = drawServe(mRandom, mSpeedCurve, mScoreCounter.getStage(), mScoreCounter.getHigherScorePlayer());
+	Dot dot = getDot();
+	dot.reset(serve.velX, serve.velY);
+
+	mCountdownTicks = COUNTDOWN_TICKS;
+	dot.setIsRooling(false);
+}
+
+void Match::updateBarGrid(int totalBars)
+{
+	for (int i = 0; i < totalBars; ++i)
+	{
+		const Obstacle& obstacle = mObstacles[i];
+		SDL_Rect swept = {
+			std::min(obstacle.box.x, obstacle.box.x + obstacle.velX),
+			std::min(obstacle.box.y, obstacle.box.y + obstacle.velY),
+			obstacle.box.w + std::abs(obstacle.velX),
+			obstacle.box.h + std::abs(obstacle.velY)
+		};
+		mBarGrid.update(i, swept);
+	}
+}
+
+void Match::launchExtraBalls()
+{
+	int totalBalls = mEntities.getBallCount();
+	for (int i = 1; i < totalBalls; ++i)
+	{
+		mEntities.ballX[i] = mRandom.below(SCREEN_WIDTH - Dot::DOT_WIDTH + 1);
+		mEntities.ballY[i] = PLAYFIELD_TOP + mRandom.below(SCREEN_HEIGHT - PLAYFIELD_TOP - Dot::DOT_HEIGHT + 1);
+		mEntities.ballPrevX[i] = mEntities.ballX[i];
+		mEntities.ballPrevY[i] = mEntities.ballY[i];
+
+		//Never still on an axis, so no ball just sits on a line
+		mEntities.ballVelX[i] = (mRandom.below(MAX_EXTRA_BALL_SPEED) + 1) * (mRandom.coinFlip() ? -1 : 1);
+		mEntities.ballVelY[i] = (mRandom.below(MAX_EXTRA_BALL_SPEED) + 1) * (mRandom.coinFlip() ? -1 : 1);
+		mEntities.ballRolling[i] = 1;
+	}
+}
+
+bool Match::isOver()
+{
+	return mScoreCounter.getVictoryPlayer() != 0;
+}
+
+int Match::getWinner()
+{
+	return mScoreCounter.getVictoryPlayer();
+}
+
+int Match::getCountdownTicks()
+{
+	return mCountdownTicks;
+}
+
+int Match::getTickCount()
+{
+	return mTickCount;
+}
+
+MatchStats& Match::getStats()
+{
+	return mStats;
+}
+
+Dot Match::getDot()
+{
+	return Dot(mEntities, 0);
+}
+
+PBar Match::getBar(int index)
+{
+	return PBar(mEntities, index);
+}
+
+int Match::getBarCount()
+{
+	return mEntities.getBarCount();
+}
+
+ScoreCounter& Match::getScoreCounter()
+{
+	return mScoreCounter;
+}
+
+EntityStore& Match::getEntities()
+{
+	return mEntities;
+}
@@ -0,0 +1,230 @@
+#pragma once
+#include <SDL.h>
+#include <vector>
+#include "GameObjects.h"
+#include "EntityStore.h"
+#include "Arena.h"
+#include "ScoreCounter.h"
+#include "Random.h"
+#include "Profiler.h"
+
+class ReplayWriter;
+
+//Simulation runs in fixed ticks, velocities are in pixels per tick
+const int SIM_TICKS_PER_SECOND = 60;
+const double SIM_TICK_SECONDS = 1.0 / SIM_TICKS_PER_SECOND;
+
+//How serve speed grows with the stage
+//Each axis gets minSpeed plus a random amount below the stage's range
+struct SpeedCurve
+{
+	int minSpeed;
+	int baseRange;
+	int rangePerStage;
+	int maxRange;
+};
+
+//The original curve, range 5 + stage capped at 15
+const SpeedCurve DEFAULT_SPEED_CURVE = { 5, 5, 1, 15 };
+
+//Velocity the ball is served with
+struct Serve
+{
+	int velX;
+	int velY;
+};
+
+//Draws a serve for the stage, speed is random within the stage's range on each axis
+//The ball heads towards the leading player, or a random side on a tie, and randomly up or down
+Serve drawServe(Random& random, const SpeedCurve& speedCurve, int stage, int higherScorePlayer);
+
+//Which of a player's bars can move, the same choices as keys 1/2/3 and 8/9/0
+enum BarMode
+{
+	//Left to whoever sets the mode to decide
+	BAR_MODE_AUTO = 0,
+
+	//Only the bar in front of the goal
+	BAR_MODE_GOAL_BAR = 1,
+
+	//Only the tall bar in the middle of the field
+	BAR_MODE_FRONT_BAR = 2,
+
+	BAR_MODE_BOTH = 3
+};
+
+//Most stages tracked in match statistics, later stages count as the last one
+const int MAX_TRACKED_STAGES = 8;
+
+//What happened during a match
+struct MatchStats
+{
+	//Points played and the bar hits in them, including the rally finishStats cut off
+	int points;
+	int barHits;
+	int longestRally;
+
+	//Rallies still in play when the match was cut off, 0 or 1 per match
+	int cutOffRallies;
+
+	//Goals scored while each stage was being played
+	int goalsPerStage[MAX_TRACKED_STAGES];
+};
+
+//Everything a tick changes, saved and restored to roll a match back to an earlier tick
+//The arrays keep their size between saves, so saving the same match again doesn't allocate
+struct MatchSnapshot
+{
+	//Ball and bar arrays, the rest of the entities never move
+	std::vector<int> ballX;
+	std::vector<int> ballY;
+	std::vector<int> ballPrevX;
+	std::vector<int> ballPrevY;
+	std::vector<int> ballVelX;
+	std::vector<int> ballVelY;
+	std::vector<Uint8> ballRolling;
+	std::vector<int> barX;
+	std::vector<int> barY;
+	std::vector<int> barPrevX;
+	std::vector<int> barPrevY;
+	std::vector<int> barVelX;
+	std::vector<int> barVelY;
+	std::vector<Uint8> barDisabled;
+
+	ScoreCounter scoreCounter;
+	int countdownTicks;
+	int tickCount;
+	Random random;
+	MatchStats stats;
+	int rallyHits;
+};
+
+//One game of two players, two bars each, without any rendering
+class Match
+{
+public:
+	//Ticks the ball is held before every serve
+	static const int COUNTDOWN_TICKS = 3 * SIM_TICKS_PER_SECOND;
+
+	//Side of the bar grid's cells
+	static const int BAR_CELL_SIZE = 64;
+
+	//Fastest an extra ball moves on each axis in multiball mode
+	static const int MAX_EXTRA_BALL_SPEED = 8;
+
+	//Initializes the variables, the match plays on the standard arena
+	Match();
+
+	//Rebuilds the bars, goals and walls from an arena and resets the match
+	//The arena is shared, not copied, so any number of matches can play on the same one
+	void setArena(ArenaHandle arena);
+	ArenaHandle getArena();
+
+	//Sets how serve speed grows, used from the next serve on
+	void setSpeedCurve(const SpeedCurve& speedCurve);
+	SpeedCurve getSpeedCurve();
+
+	//Restarts the match's random sequence, reset afterwards to replay a match
+	void setSeed(Uint64 seed);
+	Uint64 getSeed();
+
+	//Sets how many balls bounce around besides the one in play, 0 turns multiball off
+	//Extra balls are launched on reset, they bounce off walls and bars but never score
+	void setExtraBalls(int totalExtraBalls);
+	int getExtraBalls();
+
+	//Times the collision phase of every tick with the profiler, none if NULL
+	void setProfiler(Profiler* profiler);
+
+	//Records the bar inputs of every tick, none if NULL
+	void setRecorder(ReplayWriter* recorder);
+
+	//Puts bars, dot and score back to the start of a match
+	void reset();
+
+	//Takes key presses and passes them on to the bars
+	void handleEvent(SDL_Event& e);
+
+	//Enables and disables a player's bars
+	void setBarMode(int player, BarMode mode);
+
+	//Advances the match by one tick
+	void tick();
+
+	//Adds the rally in play to the stats, call once when the match is cut off before it's over
+	void finishStats();
+
+	//Saves the state of the ball, bars and score, or puts it back
+	//Only a match with the same arena and number of balls can load a snapshot
+	void saveSnapshot(MatchSnapshot& snapshot);
+	void loadSnapshot(const MatchSnapshot& snapshot);
+
+	//Gets match state
+	bool isOver();
+	int getWinner();
+	int getCountdownTicks();
+	int getTickCount();
+	MatchStats& getStats();
+
+	//Gets a hash of the ball, bar and score state, matches that played the same ticks have the same one
+	Uint32 getChecksum();
+
+	//Gets handles to match objects
+	Dot getDot();
+	PBar getBar(int index);
+	int getBarCount();
+	ScoreCounter& getScoreCounter();
+
+	//Gets every ball, bar, wall and goal of the match
+	EntityStore& getEntities();
+
+private:
+	//Puts the ball back in the center and holds it for the countdown
+	void serve();
+
+	//Moves the bars that moved in the grid
+	void updateBarGrid(int totalBars);
+
+	//Scatters the extra balls over the playfield with random velocities
+	void launchExtraBalls();
+
+	//Layout the match plays on
+	ArenaHandle mArena;
+
+	//Match objects, the ball in play first, then any extra balls, bars and walls in the arena's order
+	EntityStore mEntities;
+
+	//Bars as they moved this tick, then the arena's walls, which are copied in once
+	std::vector<Obstacle> mObstacles;
+
+	//Per tick scratch space, sized once so ticks don't allocate
+	std::vector<Uint32> mHitMasks;
+	std::vector<int> mCandidates;
+
+	//Broadphase over the bars, each covers where it was and where it went this tick
+	//The walls are in the arena's own grid
+	SpatialGrid mBarGrid;
+
+	ScoreCounter mScoreCounter;
+
+	//Ticks left until the ball is served
+	int mCountdownTicks;
+
+	//Ticks since the match started
+	int mTickCount;
+
+	SpeedCurve mSpeedCurve;
+
+	//Serve randomness, owned by the match so matches stay independent
+	Random mRandom;
+	MatchStats mStats;
+
+	//Optional, times collision
+	Profiler* mProfiler;
+
+	//Optional, records inputs
+	ReplayWriter* mRecorder;
+
+	//Bar hits in the point being played
+	int mRallyHits;
+};
@@ -0,0 +1,324 @@
+//Winsock has to come before anything that pulls in windows.h
+#ifdef _WIN32
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#else
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+#endif
+#include "NetTransport.h"
+#include <stdio.h>
+#include <string.h>
+
+#ifdef _WIN32
+typedef SOCKET NativeSocket;
+typedef int SocketLength;
+#else
+typedef int NativeSocket;
+typedef socklen_t SocketLength;
+#endif
+
+//Stored in place of a socket that isn't open
+static const long long NO_SOCKET = -1;
+
+LocalTransport::LocalTransport()
+{
+	mPeer = NULL;
+	mPackets.resize(QUEUE_PACKETS * MAX_PACKET_SIZE);
+	mFirst = 0;
+	mCount = 0;
+}
+
+void LocalTransport::connect(LocalTransport& first, LocalTransport& second)
+{
+	first.mPeer = &second;
+	second.mPeer = &first;
+}
+
+bool LocalTransport::send(const Uint8* data, int size)
+{
+	if (mPeer == NULL || size > MAX_PACKET_SIZE)
+	{
+		return false;
+	}
+
+	//A full queue drops the packet, the sender can't tell
+	mPeer->push(data, size);
+	return true;
+}
+
+bool LocalTransport::push(const Uint8* data, int size)
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+	if (mCount == QUEUE_PACKETS)
+	{
+		return false;
+	}
+
+	int slot = (mFirst + mCount) % QUEUE_PACKETS;
+	memcpy(&mPackets[slot * MAX_PACKET_SIZE], data, size);
+	mSizes[slot] = size;
+	mCount += 1;
+	return true;
+}
+
+int LocalTransport::receive(Uint8* data, int capacity)
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+	while (mCount > 0)
+	{
+		int slot = mFirst;
+		mFirst = (mFirst + 1) % QUEUE_PACKETS;
+		mCount -= 1;
+
+		//Like a datagram socket, a packet too big for the buffer is lost
+		if (mSizes[slot] <= capacity)
+		{
+			memcpy(data, &mPackets[slot * MAX_PACKET_SIZE], mSizes[slot]);
+			return mSizes[slot];
+		}
+	}
+	return 0;
+}
+
+UdpTransport::UdpTransport()
+{
+	mSocket = NO_SOCKET;
+	mRemoteAddress = 0;
+	mRemotePort = 0;
+	mIsStarted = false;
+}
+
+UdpTransport::~UdpTransport()
+{
+	close();
+}
+
+bool UdpTransport::open(int localPort, const char* remoteAddress, int remotePort)
+{
+	close();
+
+#ifdef _WIN32
+	WSADATA wsaData;
+	if (WSAStartup(MAKEWORD(2, 2), &wsaData) != 0)
+	{
+		printf("Unable to start Winsock!\n");
+		return false;
+	}
+	mIsStarted = true;
+#endif
+
+	in_addr remote;
+	if (inet_pton(AF_INET, remoteAddress, &remote) != 1)
+	{
+		printf("Invalid IPv4 address %s!\n", remoteAddress);
+		close();
+		return false;
+	}
+	mRemoteAddress = remote.s_addr;
+	mRemotePort = htons((Uint16)remotePort);
+
+	NativeSocket native = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+#ifdef _WIN32
+	mSocket = native == INVALID_SOCKET ? NO_SOCKET : (long long)native;
+#else
+	mSocket = native;
+#endif
+	if (mSocket == NO_SOCKET)
+	{
+		printf("Unable to create a UDP socket!\n");
+		close();
+		return false;
+	}
+
+	sockaddr_in local;
+	memset(&local, 0, sizeof(local));
+	local.sin_family = AF_INET;
+	local.sin_addr.s_addr = htonl(INADDR_ANY);
+	local.sin_port = htons((Uint16)localPort);
+	if (bind(native, (sockaddr*)&local, sizeof(local)) != 0)
+	{
+		printf("Unable to bind UDP port %d!\n", localPort);
+		close();
+		return false;
+	}
+
+	//Reads return at once when nothing arrived
+#ifdef _WIN32
+	u_long nonBlocking = 1;
+	ioctlsocket(native, FIONBIO, &nonBlocking);
+#else
+	fcntl(native, F_SETFL, fcntl(native, F_GETFL, 0) | O_NONBLOCK);
+#endif
+	return true;
+}
+
+void UdpTransport::close()
+{
+	if (mSocket != NO_SOCKET)
+	{
+#ifdef _WIN32
+		closesocket((NativeSocket)mSocket);
+#else
+		::close((NativeSocket)mSocket);
+#endif
+	}
+#ifdef _WIN32
+	if (mIsStarted)
+	{
+		WSACleanup();
+	}
+#endif
+	mSocket = NO_SOCKET;
+	mRemoteAddress = 0;
+	mRemotePort = 0;
+	mIsStarted = false;
+}
+
+bool UdpTransport::send(const Uint8* data, int size)
+{
+	if (mSocket == NO_SOCKET)
+	{
+		return false;
+	}
+
+	sockaddr_in remote;
+	memset(&remote, 0, sizeof(remote));
+	remote.sin_family = AF_INET;
+	remote.sin_addr.s_addr = mRemoteAddress;
+	remote.sin_port = mRemotePort;
+	return sendto((NativeSocket)mSocket, (const char*)data, size, 0, (sockaddr*)&remote, sizeof(remote)) == size;
+}
+
+int UdpTransport::receive(Uint8* data, int capacity)
+{
+	if (mSocket == NO_SOCKET)
+	{
+		return 0;
+	}
+
+	while (true)
+	{
+		sockaddr_in sender;
+		SocketLength senderLength = sizeof(sender);
+		int size = (int)recvfrom((NativeSocket)mSocket, (char*)data, capacity, 0, (sockaddr*)&sender, &senderLength);
+		if (size < 0)
+		{
+#ifdef _WIN32
+			//Windows reports a packet that bounced off a closed port on the next read, the peer may just not be up yet
+			if (WSAGetLastError() == WSAECONNRESET)
+			{
+				continue;
+			}
+#else
+			if (errno == EINTR)
+			{
+				continue;
+			}
+#endif
+			return 0;
+		}
+
+		//Only the peer's packets count
+		if (sender.sin_addr.s_addr == mRemoteAddress && sender.sin_port == mRemotePort && size > 0)
+		{
+			return size;
+		}
+	}
+}
+
+LaggyTransport::LaggyTransport(NetTransport* transport, Uint64 seed) : mRandom(seed)
+{
+	mTransport = transport;
+	mLatency = 0.0;
+	mJitter = 0.0;
+	mLossPercent = 0;
+	mTime = 0.0;
+	mPackets.resize(MAX_DELAYED_PACKETS * MAX_PACKET_SIZE);
+	for (int i = 0; i < MAX_DELAYED_PACKETS; ++i)
+	{
+		mSizes[i] = 0;
+		mDueTimes[i] = -1.0;
+	}
+	mSentCount = 0;
+	mLostCount = 0;
+}
+
+void LaggyTransport::setLag(double latencySeconds, double jitterSeconds, int lossPercent)
+{
+	mLatency = latencySeconds;
+	mJitter = jitterSeconds;
+	mLossPercent = lossPercent;
+}
+
+void LaggyTransport::advance(double seconds)
+{
+	mTime += seconds;
+	for (int i = 0; i < MAX_DELAYED_PACKETS; ++i)
+	{
+		if (mDueTimes[i] >= 0.0 && mDueTimes[i] <= mTime)
+		{
+			mTransport->send(&mPackets[i * MAX_PACKET_SIZE], mSizes[i]);
+			mDueTimes[i] = -1.0;
+		}
+	}
+}
+
+bool LaggyTransport::send(const Uint8* data, int size)
+{
+	if (size > MAX_PACKET_SIZE)
+	{
+		return false;
+	}
+
+	mSentCount += 1;
+	if (mLossPercent > 0 && mRandom.below(100) < mLossPercent)
+	{
+		mLostCount += 1;
+		return true;
+	}
+
+	double delay = mLatency;
+	if (mJitter > 0.0)
+	{
+		delay += mJitter * mRandom.below(1001) / 1000.0;
+	}
+	if (delay <= 0.0)
+	{
+		return mTransport->send(data, size);
+	}
+
+	for (int i = 0; i < MAX_DELAYED_PACKETS; ++i)
+	{
+		if (mDueTimes[i] < 0.0)
+		{
+			memcpy(&mPackets[i * MAX_PACKET_SIZE], data, size);
+			mSizes[i] = size;
+			mDueTimes[i] = mTime + delay;
+			return true;
+		}
+	}
+
+	//Too many in flight, like a congested link
+	mLostCount += 1;
+	return true;
+}
+
+int LaggyTransport::receive(Uint8* data, int capacity)
+{
+	return mTransport->receive(data, capacity);
+}
+
+int LaggyTransport::getSentCount()
+{
+	return mSentCount;
+}
+
+int LaggyTransport::getLostCount()
+{
+	return mLostCount;
+}
@@ -0,0 +1,124 @@
+#pragma once
+#include <SDL.h>
+#include <mutex>
+#include <vector>
+#include "Random.h"
+
+//Largest packet a transport carries
+const int MAX_PACKET_SIZE = 512;
+
+//Sends packets to the other peer of a netplay match and receives theirs
+//Packets may be lost, duplicated or arrive out of order, but never arrive cut short
+class NetTransport
+{
+public:
+	virtual ~NetTransport() {}
+
+	//Sends a packet, returns false if it couldn't be sent at all
+	virtual bool send(const Uint8* data, int size) = 0;
+
+	//Copies the next packet that arrived into data, returns its size or 0 if none is waiting
+	virtual int receive(Uint8* data, int capacity) = 0;
+};
+
+//Passes packets between two peers in the same process, for tests and headless runs
+//Each end has a fixed queue like a socket buffer, packets sent to a full queue are dropped
+class LocalTransport : public NetTransport
+{
+public:
+	//Packets an end holds before it starts dropping them
+	static const int QUEUE_PACKETS = 64;
+
+	//Initializes variables, the end isn't connected to anything yet
+	LocalTransport();
+
+	//Connects two ends, what one sends the other receives
+	static void connect(LocalTransport& first, LocalTransport& second);
+
+	bool send(const Uint8* data, int size);
+	int receive(Uint8* data, int capacity);
+
+private:
+	//Adds a packet to this end's queue
+	bool push(const Uint8* data, int size);
+
+	LocalTransport* mPeer;
+
+	//Ring of received packets, guarded so the two ends can run on different threads
+	std::mutex mMutex;
+	std::vector<Uint8> mPackets;
+	int mSizes[QUEUE_PACKETS];
+	int mFirst;
+	int mCount;
+};
+
+//Sends packets over a UDP socket, non-blocking so it never holds up a frame
+class UdpTransport : public NetTransport
+{
+public:
+	//Initializes variables
+	UdpTransport();
+
+	//Closes the socket
+	~UdpTransport();
+
+	//Binds to a local port and sends to the given IPv4 address and port
+	bool open(int localPort, const char* remoteAddress, int remotePort);
+	void close();
+
+	bool send(const Uint8* data, int size);
+	int receive(Uint8* data, int capacity);
+
+private:
+	//Socket handle, kept as a long long on every platform so the header needs no system includes
+	long long mSocket;
+
+	//Remote address in network byte order
+	Uint32 mRemoteAddress;
+	Uint16 mRemotePort;
+
+	//Whether the socket library was started, only Windows needs it
+	bool mIsStarted;
+};
+
+//Wraps a transport and makes it worse, delaying and dropping the packets sent through it
+//Time only moves when advance is called, so a headless run sees the same network every time
+class LaggyTransport : public NetTransport
+{
+public:
+	//Packets held back at once, more are dropped
+	static const int MAX_DELAYED_PACKETS = 128;
+
+	//Initializes variables, passes packets straight through until the lag is set
+	LaggyTransport(NetTransport* transport, Uint64 seed = 0);
+
+	//Sets the one way delay, a random extra delay up to jitter, and the chance in percent of a packet being lost
+	void setLag(double latencySeconds, double jitterSeconds, int lossPercent);
+
+	//Moves time on and sends the packets that are due
+	void advance(double seconds);
+
+	bool send(const Uint8* data, int size);
+	int receive(Uint8* data, int capacity);
+
+	//Gets how many packets were sent and lost
+	int getSentCount();
+	int getLostCount();
+
+private:
+	NetTransport* mTransport;
+	Random mRandom;
+
+	double mLatency;
+	double mJitter;
+	int mLossPercent;
+	double mTime;
+
+	//Held back packets and when each is due, a negative time marks a free slot
+	std::vector<Uint8> mPackets;
+	int mSizes[MAX_DELAYED_PACKETS];
+	double mDueTimes[MAX_DELAYED_PACKETS];
+
+	int mSentCount;
+	int mLostCount;
+};
@@ -0,0 +1,204 @@
+#include "Profiler.h"
+#include <algorithm>
+#include "TraceRecorder.h"
+
+Profiler::Profiler()
+{
+	for (int i = 0; i < HISTORY_FRAMES; ++i)
+	{
+		mFrameMs[i] = 0.0;
+		mDrawCalls[i] = 0;
+		mFrameAllocations[i] = AllocationCounts();
+		std::fill(mZoneMs[i], mZoneMs[i] + PROFILE_ZONE_TOTAL, 0.0);
+		std::fill(mZoneAllocations[i], mZoneAllocations[i] + PROFILE_ZONE_TOTAL, 0);
+	}
+	std::fill(mCurrentZoneMs, mCurrentZoneMs + PROFILE_ZONE_TOTAL, 0.0);
+	std::fill(mCurrentZoneAllocations, mCurrentZoneAllocations + PROFILE_ZONE_TOTAL, 0);
+	mFrameStartAllocations = AllocationTracker::getThreadCounts();
+	mLastChangeAllocations = mFrameStartAllocations;
+	mNextFrame = 0;
+	mTotalFrames = 0;
+	mCurrentDrawCalls = 0;
+	mZoneDepth = 0;
+	mIsOverlayShown = false;
+	mFrameStart = Clock::now();
+	mLastChange = mFrameStart;
+}
+
+void Profiler::beginFrame()
+{
+	TraceRecorder::begin("Frame");
+	mFrameStart = Clock::now();
+	mLastChange = mFrameStart;
+	mZoneDepth = 0;
+	std::fill(mCurrentZoneMs, mCurrentZoneMs + PROFILE_ZONE_TOTAL, 0.0);
+	mCurrentDrawCalls = 0;
+	mFrameStartAllocations = AllocationTracker::getThreadCounts();
+	mLastChangeAllocations = mFrameStartAllocations;
+	std::fill(mCurrentZoneAllocations, mCurrentZoneAllocations + PROFILE_ZONE_TOTAL, 0);
+}
+
+void Profiler::endFrame()
+{
+	Clock::time_point now = Clock::now();
+	chargeOpenZone(now);
+
+	//Close whatever is still open so the trace stays balanced
+	for (; mZoneDepth > 0; --mZoneDepth)
+	{
+		TraceRecorder::end();
+	}
+	TraceRecorder::end();
+
+	mFrameMs[mNextFrame] = std::chrono::duration<double, std::milli>(now - mFrameStart).count();
+	std::copy(mCurrentZoneMs, mCurrentZoneMs + PROFILE_ZONE_TOTAL, mZoneMs[mNextFrame]);
+	mDrawCalls[mNextFrame] = mCurrentDrawCalls;
+	mFrameAllocations[mNextFrame] = mLastChangeAllocations - mFrameStartAllocations;
+	std::copy(mCurrentZoneAllocations, mCurrentZoneAllocations + PROFILE_ZONE_TOTAL, mZoneAllocations[mNextFrame]);
+
+	mNextFrame = (mNextFrame + 1) % HISTORY_FRAMES;
+	mTotalFrames = std::min(mTotalFrames + 1, (int)HISTORY_FRAMES);
+}
+
+void Profiler::beginZone(ProfileZone zone)
+{
+	Clock::time_point now = Clock::now();
+	chargeOpenZone(now);
+	TraceRecorder::begin(getZoneName(zone));
+
+	//Too deep, the time goes to the outer zone
+	if (mZoneDepth < MAX_ZONE_DEPTH)
+	{
+		mOpenZones[mZoneDepth] = zone;
+	}
+	mZoneDepth += 1;
+}
+
+void Profiler::endZone()
+{
+	chargeOpenZone(Clock::now());
+	if (mZoneDepth > 0)
+	{
+		TraceRecorder::end();
+		mZoneDepth -= 1;
+	}
+}
+
+void Profiler::chargeOpenZone(Clock::time_point now)
+{
+	AllocationCounts allocations = AllocationTracker::getThreadCounts();
+	if (mZoneDepth > 0)
+	{
+		ProfileZone zone = mOpenZones[std::min(mZoneDepth, (int)MAX_ZONE_DEPTH) - 1];
+		mCurrentZoneMs[zone] += std::chrono::duration<double, std::milli>(now - mLastChange).count();
+		mCurrentZoneAllocations[zone] += allocations.allocations - mLastChangeAllocations.allocations;
+	}
+	mLastChange = now;
+	mLastChangeAllocations = allocations;
+}
+
+void Profiler::countDrawCalls(int drawCalls)
+{
+	mCurrentDrawCalls += drawCalls;
+}
+
+void Profiler::toggleOverlay()
+{
+	mIsOverlayShown = !mIsOverlayShown;
+}
+
+bool Profiler::isOverlayShown()
+{
+	return mIsOverlayShown;
+}
+
+int Profiler::getTotalFrames()
+{
+	return mTotalFrames;
+}
+
+double Profiler::getFrameMs(int framesAgo)
+{
+	return mFrameMs[(mNextFrame - 1 - framesAgo + 2 * HISTORY_FRAMES) % HISTORY_FRAMES];
+}
+
+double Profiler::getZoneMs(int framesAgo, ProfileZone zone)
+{
+	return mZoneMs[(mNextFrame - 1 - framesAgo + 2 * HISTORY_FRAMES) % HISTORY_FRAMES][zone];
+}
+
+int Profiler::getDrawCalls(int framesAgo)
+{
+	return mDrawCalls[(mNextFrame - 1 - framesAgo + 2 * HISTORY_FRAMES) % HISTORY_FRAMES];
+}
+
+AllocationCounts Profiler::getFrameAllocations(int framesAgo)
+{
+	return mFrameAllocations[(mNextFrame - 1 - framesAgo + 2 * HISTORY_FRAMES) % HISTORY_FRAMES];
+}
+
+long long Profiler::getZoneAllocations(int framesAgo, ProfileZone zone)
+{
+	return mZoneAllocations[(mNextFrame - 1 - framesAgo + 2 * HISTORY_FRAMES) % HISTORY_FRAMES][zone];
+}
+
+double Profiler::getFramePercentileMs(double percentile)
+{
+	if (mTotalFrames == 0)
+	{
+		return 0.0;
+	}
+
+	double sorted[HISTORY_FRAMES];
+	for (int i = 0; i < mTotalFrames; ++i)
+	{
+		sorted[i] = getFrameMs(i);
+	}
+
+	//Nearest rank, only the one element needs to end up in place
+	int rank = (int)(percentile / 100.0 * (mTotalFrames - 1) + 0.5);
+	std::nth_element(sorted, sorted + rank, sorted + mTotalFrames);
+	return sorted[rank];
+}
+
+double Profiler::getMaxFrameMs()
+{
+	double maxMs = 0.0;
+	for (int i = 0; i < mTotalFrames; ++i)
+	{
+		maxMs = std::max(maxMs, getFrameMs(i));
+	}
+	return maxMs;
+}
+
+const char* Profiler::getZoneName(ProfileZone zone)
+{
+	switch (zone)
+	{
+	case PROFILE_ZONE_EVENTS: return "Events";
+	case PROFILE_ZONE_SIMULATION: return "Simulation";
+	case PROFILE_ZONE_COLLISION: return "Collision";
+	case PROFILE_ZONE_BACKGROUND: return "Background";
+	case PROFILE_ZONE_SPRITES: return "Sprites";
+	case PROFILE_ZONE_TEXT: return "Text";
+	case PROFILE_ZONE_PRESENT: return "Present";
+	default: return "?";
+	}
+}
+
+ProfileScope::ProfileScope(Profiler* profiler, ProfileZone zone)
+{
+	mProfiler = profiler;
+	if (mProfiler != NULL)
+	{
+		mProfiler->beginZone(zone);
+	}
+}
+
+ProfileScope::~ProfileScope()
+{
+	if (mProfiler != NULL)
+	{
+		mProfiler->endZone();
+	}
+}
@@ -0,0 +1,112 @@
+#pragma once
+#include <chrono>
+#include "AllocationTracker.h"
+
+//Phases of a frame that get timed separately
+enum ProfileZone
+{
+	PROFILE_ZONE_EVENTS = 0,
+	PROFILE_ZONE_SIMULATION = 1,
+	PROFILE_ZONE_COLLISION = 2,
+	PROFILE_ZONE_BACKGROUND = 3,
+	PROFILE_ZONE_SPRITES = 4,
+	PROFILE_ZONE_TEXT = 5,
+	PROFILE_ZONE_PRESENT = 6,
+	PROFILE_ZONE_TOTAL = 7
+};
+
+//Times the zones of every frame and keeps the last few hundred frames
+//Zones can nest, time spent in an inner zone is not counted for the outer one
+//Frames and zones also go to the trace recorder
+//Allocations of the profiling thread are charged to zones the same way as time
+//Uses the steady clock, which is the performance counter on Windows, so the headless build needs no SDL library
+class Profiler
+{
+public:
+	//Frames kept for the graph and the percentiles
+	static const int HISTORY_FRAMES = 300;
+
+	//Deepest zone nesting
+	static const int MAX_ZONE_DEPTH = 8;
+
+	//Initializes variables
+	Profiler();
+
+	//Starts and finishes timing a frame
+	void beginFrame();
+	void endFrame();
+
+	//Starts and finishes timing a zone within the frame
+	void beginZone(ProfileZone zone);
+	void endZone();
+
+	//Adds render calls to the frame being timed
+	void countDrawCalls(int drawCalls);
+
+	//Shows or hides the overlay, timing goes on either way
+	void toggleOverlay();
+	bool isOverlayShown();
+
+	//Gets frames recorded so far, at most the history
+	int getTotalFrames();
+
+	//Gets timings in milliseconds, 0 frames ago is the last finished frame
+	double getFrameMs(int framesAgo);
+	double getZoneMs(int framesAgo, ProfileZone zone);
+	int getDrawCalls(int framesAgo);
+
+	//Gets allocations of the profiling thread, for the whole frame or one zone
+	AllocationCounts getFrameAllocations(int framesAgo);
+	long long getZoneAllocations(int framesAgo, ProfileZone zone);
+
+	//Gets frame time percentile over the history, from 0 to 100
+	double getFramePercentileMs(double percentile);
+	double getMaxFrameMs();
+
+	//Gets zone display name
+	static const char* getZoneName(ProfileZone zone);
+
+private:
+	typedef std::chrono::steady_clock Clock;
+
+	//Adds the time and allocations since the last zone change to the innermost open zone
+	void chargeOpenZone(Clock::time_point now);
+
+	//Recorded frames, a ring buffer
+	double mFrameMs[HISTORY_FRAMES];
+	double mZoneMs[HISTORY_FRAMES][PROFILE_ZONE_TOTAL];
+	int mDrawCalls[HISTORY_FRAMES];
+	AllocationCounts mFrameAllocations[HISTORY_FRAMES];
+	long long mZoneAllocations[HISTORY_FRAMES][PROFILE_ZONE_TOTAL];
+	int mNextFrame;
+	int mTotalFrames;
+
+	//Frame being timed
+	Clock::time_point mFrameStart;
+	Clock::time_point mLastChange;
+	double mCurrentZoneMs[PROFILE_ZONE_TOTAL];
+	int mCurrentDrawCalls;
+	AllocationCounts mFrameStartAllocations;
+	AllocationCounts mLastChangeAllocations;
+	long long mCurrentZoneAllocations[PROFILE_ZONE_TOTAL];
+
+	//Open zones, innermost last
+	ProfileZone mOpenZones[MAX_ZONE_DEPTH];
+	int mZoneDepth;
+
+	bool mIsOverlayShown;
+};
+
+//The game's profiler, render code counts its draw calls into it
+extern Profiler gProfiler;
+
+//Times a zone until the end of the enclosing scope, does nothing without a profiler
+class ProfileScope
+{
+public:
+	ProfileScope(Profiler* profiler, ProfileZone zone);
+	~ProfileScope();
+
+private:
+	Profiler* mProfiler;
+};
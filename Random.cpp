@@ -0,0 +1,62 @@
+#include "Random.h"
+
+//PCG32 multiplier and stream
+static const Uint64 PCG_MULTIPLIER = 6364136223846793005ULL;
+static const Uint64 PCG_INCREMENT = 1442695040888963407ULL;
+
+Random::Random(Uint64 seed)
+{
+	this->seed(seed);
+}
+
+void Random::seed(Uint64 seed)
+{
+	mSeed = seed;
+
+	//Mix the seed in the way the PCG reference does
+	mState = 0;
+	next();
+	mState += seed;
+	next();
+}
+
+Uint64 Random::getSeed()
+{
+	return mSeed;
+}
+
+Uint32 Random::next()
+{
+	Uint64 oldState = mState;
+	mState = oldState * PCG_MULTIPLIER + PCG_INCREMENT;
+
+	//Output permutation, xorshift then random rotation
+	Uint32 xorShifted = (Uint32)(((oldState >> 18u) ^ oldState) >> 27u);
+	Uint32 rotation = (Uint32)(oldState >> 59u);
+	return (xorShifted >> rotation) | (xorShifted << ((0u - rotation) & 31u));
+}
+
+int Random::below(int range)
+{
+	if (range <= 1)
+	{
+		return 0;
+	}
+
+	//Scale into the range by multiplication, rejecting the few values that would bias it
+	Uint32 bound = (Uint32)range;
+	Uint32 threshold = (0u - bound) % bound;
+	while (true)
+	{
+		Uint64 product = (Uint64)next() * bound;
+		if ((Uint32)product >= threshold)
+		{
+			return (int)(product >> 32);
+		}
+	}
+}
+
+bool Random::coinFlip()
+{
+	return (next() >> 31) != 0;
+}
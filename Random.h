@@ -0,0 +1,29 @@
+#pragma once
+#include <SDL_stdinc.h>
+
+//Small, fast random number generator (PCG32)
+//Every match owns one, so matches replay from their seed and run side by side on threads
+class Random
+{
+public:
+	//Initializes the generator with the given seed
+	explicit Random(Uint64 seed = 0);
+
+	//Restarts the sequence of the given seed
+	void seed(Uint64 seed);
+	Uint64 getSeed();
+
+	//Gets the next 32 random bits
+	Uint32 next();
+
+	//Gets a uniform integer from 0 to range - 1
+	int below(int range);
+
+	//Gets true or false with even odds
+	bool coinFlip();
+
+private:
+	//Generator state and the seed it started from
+	Uint64 mState;
+	Uint64 mSeed;
+};
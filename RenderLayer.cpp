@@ -0,0 +1,123 @@
+#include "RenderLayer.h"
+#include <stdio.h>
+#include "TraceRecorder.h"
+#include "Profiler.h"
+#include "AllocationTracker.h"
+
+RenderLayer::RenderLayer()
+{
+	//Initialize
+	mRenderer = NULL;
+	mPreviousTarget = NULL;
+	mTexture = NULL;
+	mWidth = 0;
+	mHeight = 0;
+	mIsDirty = true;
+	mIsDirect = false;
+	mRedrawCount = 0;
+}
+
+RenderLayer::~RenderLayer()
+{
+	//Deallocate
+	free();
+}
+
+bool RenderLayer::beginRedraw(SDL_Renderer* renderer, int width, int height)
+{
+	//Without target textures, every frame draws the content itself
+	if (renderer != mRenderer)
+	{
+		free();
+		mRenderer = renderer;
+		mIsDirect = !SDL_RenderTargetSupported(renderer);
+	}
+	if (mIsDirect)
+	{
+		return true;
+	}
+
+	//Create the target at the new size
+	if (mTexture == NULL || width != mWidth || height != mHeight)
+	{
+		if (mTexture != NULL)
+		{
+			SDL_DestroyTexture(mTexture);
+		}
+
+		mTexture = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_RGBA8888, SDL_TEXTUREACCESS_TARGET, width, height);
+		if (mTexture == NULL)
+		{
+			printf("Unable to create layer texture, drawing directly! SDL Error: %s\n", SDL_GetError());
+			mIsDirect = true;
+			return true;
+		}
+		AllocationTracker::countTexture();
+
+		//Content is opaque, copying it needs no blending
+		SDL_SetTextureBlendMode(mTexture, SDL_BLENDMODE_NONE);
+
+		mWidth = width;
+		mHeight = height;
+		mIsDirty = true;
+	}
+
+	if (!mIsDirty)
+	{
+		return false;
+	}
+
+	TraceRecorder::begin("Redraw layer");
+	mPreviousTarget = SDL_GetRenderTarget(renderer);
+	SDL_SetRenderTarget(renderer, mTexture);
+	mRedrawCount += 1;
+	return true;
+}
+
+void RenderLayer::endRedraw()
+{
+	if (mIsDirect)
+	{
+		return;
+	}
+
+	SDL_SetRenderTarget(mRenderer, mPreviousTarget);
+	mPreviousTarget = NULL;
+	mIsDirty = false;
+	TraceRecorder::end();
+}
+
+void RenderLayer::invalidate()
+{
+	mIsDirty = true;
+}
+
+void RenderLayer::render(int x, int y)
+{
+	if (mIsDirect || mTexture == NULL)
+	{
+		return;
+	}
+
+	SDL_Rect renderQuad = { x, y, mWidth, mHeight };
+	SDL_RenderCopy(mRenderer, mTexture, NULL, &renderQuad);
+	gProfiler.countDrawCalls(1);
+}
+
+int RenderLayer::getRedrawCount()
+{
+	return mRedrawCount;
+}
+
+void RenderLayer::free()
+{
+	//Free texture if it exists
+	if (mTexture != NULL)
+	{
+		SDL_DestroyTexture(mTexture);
+		mTexture = NULL;
+		mWidth = 0;
+		mHeight = 0;
+	}
+	mIsDirty = true;
+}
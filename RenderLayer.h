@@ -0,0 +1,51 @@
+#pragma once
+#include <SDL.h>
+
+//Static content drawn once into a target texture, then shown with a single copy per frame
+//Falls back to drawing every frame when the renderer has no target textures
+class RenderLayer
+{
+public:
+	//Initializes variables
+	RenderLayer();
+
+	//Deallocates memory
+	~RenderLayer();
+
+	//Returns true when the content has to be drawn, the layer stays the render target until endRedraw
+	//Happens on first use, after invalidate and when the size changes
+	bool beginRedraw(SDL_Renderer* renderer, int width, int height);
+	void endRedraw();
+
+	//Marks the content as changed, or lost after a device reset
+	void invalidate();
+
+	//Renders the layer with its top left corner at given point
+	void render(int x, int y);
+
+	//Gets how often the content was drawn
+	int getRedrawCount();
+
+	//Deallocates layer texture
+	void free();
+
+private:
+	//Target renderer and the target it had before redrawing
+	SDL_Renderer* mRenderer;
+	SDL_Texture* mPreviousTarget;
+
+	//The cached content
+	SDL_Texture* mTexture;
+
+	//Layer dimensions
+	int mWidth;
+	int mHeight;
+
+	//Content has to be drawn before the next render
+	bool mIsDirty;
+
+	//Target textures are not supported, content is drawn straight to the screen
+	bool mIsDirect;
+
+	int mRedrawCount;
+};
@@ -0,0 +1,543 @@
+#include "Replay.h"
+#include <string.h>
+#include <algorithm>
+
+//Folds the sign into the lowest bit, so small negative numbers stay short
+static Uint64 zigzag(Sint64 value)
+{
+	return ((Uint64)value << 1) ^ (Uint64)(value >> 63);
+}
+
+static Sint64 unzigzag(Uint64 value)
+{
+	return (Sint64)(value >> 1) ^ -(Sint64)(value & 1);
+}
+
+ReplayWriter::ReplayWriter()
+{
+	mFile = NULL;
+	mLastTick = 0;
+	mBuffer.reserve(REPLAY_BUFFER_SIZE);
+}
+
+ReplayWriter::~ReplayWriter()
+{
+	close();
+}
+
+bool ReplayWriter::open(const char* path, Match& match)
+{
+	close();
+	mFile = fopen(path, "wb");
+	if (mFile == NULL)
+	{
+		printf("Unable to create replay %s!\n", path);
+		return false;
+	}
+
+	for (int i = 0; i < 4; ++i)
+	{
+		mBuffer.push_back((Uint8)REPLAY_MAGIC[i]);
+	}
+	writeVarint(REPLAY_VERSION);
+	writeVarint(match.getSeed());
+
+	SpeedCurve speedCurve = match.getSpeedCurve();
+	writeSigned(speedCurve.minSpeed);
+	writeSigned(speedCurve.baseRange);
+	writeSigned(speedCurve.rangePerStage);
+	writeSigned(speedCurve.maxRange);
+	writeVarint(match.getExtraBalls());
+
+	//The arena goes in whole, so a replay plays without its layout file
+	ArenaHandle arena = match.getArena();
+	const std::vector<BarSlot>& barSlots = arena->getBarSlots();
+	writeVarint(barSlots.size());
+	for (size_t i = 0; i < barSlots.size(); ++i)
+	{
+		writeVarint(barSlots[i].player);
+		writeVarint(barSlots[i].barId);
+		writeRect(barSlots[i].box);
+	}
+	const std::vector<GoalArea>& goals = arena->getGoals();
+	writeVarint(goals.size());
+	for (size_t i = 0; i < goals.size(); ++i)
+	{
+		writeVarint(goals[i].player);
+		writeRect(goals[i].box);
+	}
+	const std::vector<SDL_Rect>& walls = arena->getWalls();
+	writeVarint(walls.size());
+	for (size_t i = 0; i < walls.size(); ++i)
+	{
+		writeRect(walls[i]);
+	}
+
+	//Bars start still and enabled, anything else is recorded on the first tick
+	mBarVelY.assign(barSlots.size(), 0);
+	mBarDisabled.assign(barSlots.size(), 0);
+	mLastTick = 0;
+	return true;
+}
+
+void ReplayWriter::recordTick(int tick, const EntityStore& entities)
+{
+	if (mFile == NULL)
+	{
+		return;
+	}
+
+	Uint32 changedMask = 0;
+	int totalBars = (int)mBarVelY.size();
+	for (int i = 0; i < totalBars; ++i)
+	{
+		if (entities.barVelY[i] != mBarVelY[i] || entities.barDisabled[i] != mBarDisabled[i])
+		{
+			changedMask |= 1u << i;
+		}
+	}
+	if (changedMask == 0)
+	{
+		return;
+	}
+
+	writeVarint(tick - mLastTick);
+	writeVarint(changedMask);
+	for (int i = 0; i < totalBars; ++i)
+	{
+		if (changedMask & (1u << i))
+		{
+			Uint64 toggled = entities.barDisabled[i] != mBarDisabled[i] ? 1 : 0;
+			writeVarint(zigzag(entities.barVelY[i] - mBarVelY[i]) << 1 | toggled);
+			mBarVelY[i] = entities.barVelY[i];
+			mBarDisabled[i] = entities.barDisabled[i];
+		}
+	}
+	mLastTick = tick;
+}
+
+void ReplayWriter::finish(Match& match)
+{
+	if (mFile == NULL)
+	{
+		return;
+	}
+
+	writeVarint(match.getTickCount() - mLastTick);
+	writeVarint(0);
+	writeVarint(match.getScoreCounter().getScore(1));
+	writeVarint(match.getScoreCounter().getScore(2));
+	writeVarint(match.getChecksum());
+	close();
+}
+
+bool ReplayWriter::isOpen()
+{
+	return mFile != NULL;
+}
+
+void ReplayWriter::writeVarint(Uint64 value)
+{
+	while (value >= 0x80)
+	{
+		mBuffer.push_back((Uint8)(value | 0x80));
+		value >>= 7;
+	}
+	mBuffer.push_back((Uint8)value);
+
+	if ((int)mBuffer.size() >= REPLAY_BUFFER_SIZE - 16)
+	{
+		flush();
+	}
+}
+
+void ReplayWriter::writeSigned(Sint64 value)
+{
+	writeVarint(zigzag(value));
+}
+
+void ReplayWriter::writeRect(const SDL_Rect& rect)
+{
+	writeSigned(rect.x);
+	writeSigned(rect.y);
+	writeVarint(rect.w);
+	writeVarint(rect.h);
+}
+
+void ReplayWriter::flush()
+{
+	if (mFile != NULL && !mBuffer.empty())
+	{
+		fwrite(mBuffer.data(), 1, mBuffer.size(), mFile);
+	}
+	mBuffer.clear();
+}
+
+void ReplayWriter::close()
+{
+	flush();
+	if (mFile != NULL)
+	{
+		fclose(mFile);
+		mFile = NULL;
+	}
+}
+
+ReplayReader::ReplayReader()
+{
+	mFile = NULL;
+	mBuffer.resize(REPLAY_BUFFER_SIZE);
+	mBufferOffset = 0;
+	mBufferPos = 0;
+	mBufferSize = 0;
+	mFailed = false;
+	mHeader = ReplayHeader();
+	mCursor.offset = 0;
+	mCursor.lastTick = 0;
+	mRecordTick = -1;
+	mRecordMask = 0;
+	mEndTick = 0;
+	mHasEnding = false;
+	mEnding = ReplayEnding();
+}
+
+ReplayReader::~ReplayReader()
+{
+	close();
+}
+
+bool ReplayReader::open(const char* path)
+{
+	close();
+	mFile = fopen(path, "rb");
+	if (mFile == NULL)
+	{
+		printf("Unable to open replay %s!\n", path);
+		return false;
+	}
+	seekFile(0);
+
+	char magic[4];
+	for (int i = 0; i < 4; ++i)
+	{
+		magic[i] = (char)readByte();
+	}
+	if (memcmp(magic, REPLAY_MAGIC, 4) != 0 || readVarint() != REPLAY_VERSION)
+	{
+		printf("%s is not a replay of this version!\n", path);
+		close();
+		return false;
+	}
+
+	mHeader.seed = readVarint();
+	mHeader.speedCurve.minSpeed = (int)readSigned();
+	mHeader.speedCurve.baseRange = (int)readSigned();
+	mHeader.speedCurve.rangePerStage = (int)readSigned();
+	mHeader.speedCurve.maxRange = (int)readSigned();
+	mHeader.extraBalls = (int)readVarint();
+
+	std::vector<BarSlot> barSlots((size_t)std::min(readVarint(), (Uint64)Arena::MAX_BAR_SLOTS + 1));
+	for (size_t i = 0; i < barSlots.size() && !mFailed; ++i)
+	{
+		barSlots[i].player = (int)readVarint();
+		barSlots[i].barId = (int)readVarint();
+		barSlots[i].box = readRect();
+	}
+	std::vector<GoalArea> goals;
+	for (Uint64 i = readVarint(); i > 0 && !mFailed; --i)
+	{
+		GoalArea goal;
+		goal.player = (int)readVarint();
+		goal.box = readRect();
+		goals.push_back(goal);
+	}
+	std::vector<SDL_Rect> walls;
+	for (Uint64 i = readVarint(); i > 0 && !mFailed; --i)
+	{
+		walls.push_back(readRect());
+	}
+
+	mHeader.arena = mFailed ? NULL : Arena::create(barSlots, goals, walls);
+	if (mHeader.arena == NULL)
+	{
+		printf("Replay %s has a broken header!\n", path);
+		close();
+		return false;
+	}
+
+	mCursor.lastTick = 0;
+	mCursor.barVelY.assign(barSlots.size(), 0);
+	mCursor.barDisabled.assign(barSlots.size(), 0);
+	readRecordStart();
+	return true;
+}
+
+void ReplayReader::close()
+{
+	if (mFile != NULL)
+	{
+		fclose(mFile);
+		mFile = NULL;
+	}
+}
+
+const ReplayHeader& ReplayReader::getHeader()
+{
+	return mHeader;
+}
+
+void ReplayReader::setupMatch(Match& match)
+{
+	match.setArena(mHeader.arena);
+	match.setSpeedCurve(mHeader.speedCurve);
+	match.setSeed(mHeader.seed);
+	match.setExtraBalls(mHeader.extraBalls);
+	match.reset();
+}
+
+bool ReplayReader::applyInputs(Match& match)
+{
+	int tick = match.getTickCount();
+	if (mRecordTick < 0 && tick >= mEndTick)
+	{
+		return false;
+	}
+
+	//Apply the record of this tick and move on to the next one
+	if (tick == mRecordTick)
+	{
+		int totalBars = (int)mCursor.barVelY.size();
+		for (int i = 0; i < totalBars; ++i)
+		{
+			if (mRecordMask & (1u << i))
+			{
+				Uint64 change = readVarint();
+				mCursor.barVelY[i] += (int)unzigzag(change >> 1);
+				mCursor.barDisabled[i] ^= (Uint8)(change & 1);
+			}
+		}
+		mCursor.lastTick = tick;
+		readRecordStart();
+	}
+
+	//Inputs hold until they change, so every tick gets all of them
+	EntityStore& entities = match.getEntities();
+	int totalBars = std::min((int)mCursor.barVelY.size(), entities.getBarCount());
+	for (int i = 0; i < totalBars; ++i)
+	{
+		entities.barVelY[i] = mCursor.barVelY[i];
+		entities.barDisabled[i] = mCursor.barDisabled[i];
+	}
+	return true;
+}
+
+bool ReplayReader::hasEnding()
+{
+	return mHasEnding;
+}
+
+const ReplayEnding& ReplayReader::getEnding()
+{
+	return mEnding;
+}
+
+ReplayReader::Cursor ReplayReader::getCursor()
+{
+	return mCursor;
+}
+
+void ReplayReader::setCursor(const Cursor& cursor)
+{
+	mCursor = cursor;
+	seekFile(cursor.offset);
+	readRecordStart();
+}
+
+void ReplayReader::readRecordStart()
+{
+	mCursor.offset = mBufferOffset + mBufferPos;
+	Uint64 ticks = readVarint();
+	Uint64 mask = readVarint();
+	mRecordTick = -1;
+
+	//A file cut short ends with its last complete record
+	if (mFailed || mask >= ((Uint64)1 << mCursor.barVelY.size()))
+	{
+		mEndTick = mCursor.lastTick;
+		mHasEnding = false;
+		return;
+	}
+
+	if (mask == 0)
+	{
+		mEndTick = mCursor.lastTick + (int)ticks;
+		mEnding.ticks = mEndTick;
+		mEnding.scores[0] = (int)readVarint();
+		mEnding.scores[1] = (int)readVarint();
+		mEnding.checksum = (Uint32)readVarint();
+		mHasEnding = !mFailed;
+		return;
+	}
+
+	mRecordTick = mCursor.lastTick + (int)ticks;
+	mRecordMask = (Uint32)mask;
+}
+
+int ReplayReader::readByte()
+{
+	if (mBufferPos == mBufferSize)
+	{
+		mBufferOffset += mBufferSize;
+		mBufferPos = 0;
+		mBufferSize = mFile != NULL ? (int)fread(mBuffer.data(), 1, mBuffer.size(), mFile) : 0;
+		if (mBufferSize == 0)
+		{
+			mFailed = true;
+			return -1;
+		}
+	}
+	return mBuffer[mBufferPos++];
+}
+
+Uint64 ReplayReader::readVarint()
+{
+	Uint64 value = 0;
+	for (int shift = 0; shift < 64; shift += 7)
+	{
+		int byte = readByte();
+		if (byte < 0)
+		{
+			return 0;
+		}
+
+		value |= (Uint64)(byte & 0x7F) << shift;
+		if ((byte & 0x80) == 0)
+		{
+			return value;
+		}
+	}
+	mFailed = true;
+	return 0;
+}
+
+Sint64 ReplayReader::readSigned()
+{
+	return unzigzag(readVarint());
+}
+
+SDL_Rect ReplayReader::readRect()
+{
+	SDL_Rect rect;
+	rect.x = (int)readSigned();
+	rect.y = (int)readSigned();
+	rect.w = (int)readVarint();
+	rect.h = (int)readVarint();
+	return rect;
+}
+
+void ReplayReader::seekFile(long offset)
+{
+	if (mFile != NULL)
+	{
+		fseek(mFile, offset, SEEK_SET);
+	}
+	mBufferOffset = offset;
+	mBufferPos = 0;
+	mBufferSize = 0;
+	mFailed = false;
+}
+
+ReplayPlayer::ReplayPlayer()
+{
+	mCheckpointInterval = DEFAULT_CHECKPOINT_INTERVAL;
+}
+
+bool ReplayPlayer::open(const char* path, int checkpointInterval)
+{
+	mCheckpoints.clear();
+	if (!mReader.open(path))
+	{
+		return false;
+	}
+
+	mCheckpointInterval = std::max(checkpointInterval, 1);
+	mReader.setupMatch(mMatch);
+	addCheckpoint();
+	return true;
+}
+
+bool ReplayPlayer::step()
+{
+	if (mMatch.isOver() || !mReader.applyInputs(mMatch))
+	{
+		return false;
+	}
+	mMatch.tick();
+
+	int tick = mMatch.getTickCount();
+	if (tick % mCheckpointInterval == 0 && tick > mCheckpoints.back().match.getTickCount())
+	{
+		addCheckpoint();
+	}
+	return true;
+}
+
+void ReplayPlayer::playToEnd()
+{
+	while (step())
+	{
+	}
+}
+
+bool ReplayPlayer::seek(int tick)
+{
+	if (mCheckpoints.empty())
+	{
+		return false;
+	}
+
+	//Closest checkpoint at or before the tick, only worth going back to if it's ahead of where the match is or the tick is behind
+	size_t closest = 0;
+	while (closest + 1 < mCheckpoints.size() && mCheckpoints[closest + 1].match.getTickCount() <= tick)
+	{
+		closest += 1;
+	}
+	Checkpoint& checkpoint = mCheckpoints[closest];
+	if (tick < mMatch.getTickCount() || checkpoint.match.getTickCount() > mMatch.getTickCount())
+	{
+		mMatch = checkpoint.match;
+		mReader.setCursor(checkpoint.cursor);
+	}
+
+	while (mMatch.getTickCount() < tick)
+	{
+		if (!step())
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+Match& ReplayPlayer::getMatch()
+{
+	return mMatch;
+}
+
+ReplayReader& ReplayPlayer::getReader()
+{
+	return mReader;
+}
+
+int ReplayPlayer::getCheckpointCount()
+{
+	return (int)mCheckpoints.size();
+}
+
+void ReplayPlayer::addCheckpoint()
+{
+	Checkpoint checkpoint;
+	checkpoint.match = mMatch;
+	checkpoint.cursor = mReader.getCursor();
+	mCheckpoints.push_back(checkpoint);
+}
@@ -0,0 +1,193 @@
+#pragma once
+#include <SDL.h>
+#include <stdio.h>
+#include <vector>
+#include "Match.h"
+
+//Layout of a replay file, every number is a LEB128 varint and signed ones are zigzag encoded
+//Header: magic, version, seed, speed curve, extra balls, then the arena's bar slots, goals and walls
+//Then a record for every tick the bar inputs changed: ticks since the last record, a mask of the bars that changed,
+//and for each of them its velocity change and whether it was enabled or disabled
+//A record with an empty mask ends the match and holds the scores and the final checksum
+const char REPLAY_MAGIC[4] = { 'P', 'P', 'R', 'P' };
+const Uint32 REPLAY_VERSION = 1;
+
+//Bytes read or written to the file at once
+const int REPLAY_BUFFER_SIZE = 4096;
+
+//How a recorded match was set up
+struct ReplayHeader
+{
+	Uint64 seed;
+	SpeedCurve speedCurve;
+	int extraBalls;
+	ArenaHandle arena;
+};
+
+//How a recorded match ended, to check playback against
+struct ReplayEnding
+{
+	int ticks;
+	int scores[2];
+	Uint32 checksum;
+};
+
+//Streams the inputs of a match to a file as it's played
+//Only changes are stored, a match of bots that move every tick takes a few bytes per tick and one of players far less
+class ReplayWriter
+{
+public:
+	//Initializes variables
+	ReplayWriter();
+
+	//Closes the file, a replay without an ending still plays up to its last record
+	~ReplayWriter();
+
+	//Creates the file and writes the header, call after the match is reset and before its first tick
+	bool open(const char* path, Match& match);
+
+	//Writes the bar inputs of a tick if they changed, the match calls this at the start of every tick
+	void recordTick(int tick, const EntityStore& entities);
+
+	//Writes the ending and closes the file
+	void finish(Match& match);
+
+	bool isOpen();
+
+private:
+	void writeVarint(Uint64 value);
+	void writeSigned(Sint64 value);
+	void writeRect(const SDL_Rect& rect);
+	void flush();
+	void close();
+
+	FILE* mFile;
+
+	//Bytes not written to the file yet
+	std::vector<Uint8> mBuffer;
+
+	//Inputs as of the last record
+	std::vector<int> mBarVelY;
+	std::vector<Uint8> mBarDisabled;
+	int mLastTick;
+};
+
+//Reads a replay from a file a buffer at a time, so replays of any length play in the same little memory
+class ReplayReader
+{
+public:
+	//Where in the replay the reader is, restoring it continues from there
+	struct Cursor
+	{
+		//Start of the next record in the file
+		long offset;
+
+		//Tick of the last record read and the inputs as of then
+		int lastTick;
+		std::vector<int> barVelY;
+		std::vector<Uint8> barDisabled;
+	};
+
+	//Initializes variables
+	ReplayReader();
+
+	//Closes the file
+	~ReplayReader();
+
+	//Opens the file and reads its header
+	bool open(const char* path);
+	void close();
+
+	const ReplayHeader& getHeader();
+
+	//Sets up and resets a match the way the recorded one started
+	void setupMatch(Match& match);
+
+	//Sets the bar inputs for the match's next tick, returns false once the replay ends
+	bool applyInputs(Match& match);
+
+	//Gets whether the replay had an ending, a file that was cut short has none
+	bool hasEnding();
+	const ReplayEnding& getEnding();
+
+	Cursor getCursor();
+	void setCursor(const Cursor& cursor);
+
+private:
+	//Reads the tick and changed bars of the next record, or the ending
+	void readRecordStart();
+
+	int readByte();
+	Uint64 readVarint();
+	Sint64 readSigned();
+	SDL_Rect readRect();
+	void seekFile(long offset);
+
+	FILE* mFile;
+
+	//File bytes from mBufferOffset on, read up to mBufferPos
+	std::vector<Uint8> mBuffer;
+	long mBufferOffset;
+	int mBufferPos;
+	int mBufferSize;
+
+	//Set when the file ended in the middle of a number
+	bool mFailed;
+
+	ReplayHeader mHeader;
+	Cursor mCursor;
+
+	//Next record, its tick is -1 once there are no more
+	int mRecordTick;
+	Uint32 mRecordMask;
+
+	//Tick the replay ends at, the ending is only there if the file wasn't cut short
+	int mEndTick;
+	bool mHasEnding;
+	ReplayEnding mEnding;
+};
+
+//Plays a replay as fast as the simulation runs, and seeks in it
+//A copy of the match is kept every few ticks, seeking starts from the closest one before the tick
+class ReplayPlayer
+{
+public:
+	//Ticks between checkpoints by default, 10 seconds of play
+	static const int DEFAULT_CHECKPOINT_INTERVAL = 10 * SIM_TICKS_PER_SECOND;
+
+	//Initializes variables
+	ReplayPlayer();
+
+	//Opens a replay and sets up its match
+	bool open(const char* path, int checkpointInterval = DEFAULT_CHECKPOINT_INTERVAL);
+
+	//Plays one tick, returns false at the end of the replay
+	bool step();
+
+	//Plays to the end
+	void playToEnd();
+
+	//Plays or rewinds to the tick, returns false if the replay ends before it
+	bool seek(int tick);
+
+	Match& getMatch();
+	ReplayReader& getReader();
+	int getCheckpointCount();
+
+private:
+	//Match and reader at a checkpoint
+	struct Checkpoint
+	{
+		Match match;
+		ReplayReader::Cursor cursor;
+	};
+
+	void addCheckpoint();
+
+	ReplayReader mReader;
+	Match mMatch;
+
+	//Checkpoints in tick order, the first one is at tick 0
+	std::vector<Checkpoint> mCheckpoints;
+	int mCheckpointInterval;
+};
@@ -0,0 +1,465 @@
+#include "Rollback.h"
+#include <stdio.h>
+#include <string.h>
+#include <algorithm>
+#include <chrono>
+#include "TraceRecorder.h"
+
+//Packet layout, all numbers little endian
+//Match id, count of the sender's inputs it has from us, the sender's latest final checksum and its tick (-1 if none),
+//then the tick of the first input and the number of inputs, each a disabled mask and the velocity of each bar
+static const int PACKET_HEADER_SIZE = 4 + 4 + 4 + 4 + 4 + 1;
+
+static void writeUint32(Uint8* data, int& offset, Uint32 value)
+{
+	for (int i = 0; i < 4; ++i)
+	{
+		data[offset++] = (Uint8)(value >> (i * 8));
+	}
+}
+
+static Uint32 readUint32(const Uint8* data, int& offset)
+{
+	Uint32 value = 0;
+	for (int i = 0; i < 4; ++i)
+	{
+		value |= (Uint32)data[offset++] << (i * 8);
+	}
+	return value;
+}
+
+static void writeUint16(Uint8* data, int& offset, Uint16 value)
+{
+	data[offset++] = (Uint8)value;
+	data[offset++] = (Uint8)(value >> 8);
+}
+
+static Uint16 readUint16(const Uint8* data, int& offset)
+{
+	Uint16 value = (Uint16)(data[offset] | (data[offset + 1] << 8));
+	offset += 2;
+	return value;
+}
+
+RollbackSession::RollbackSession()
+{
+	mMatch = NULL;
+	mTransport = NULL;
+	mLocalPlayer = 1;
+	mRemotePlayer = 2;
+	mMatchId = 0;
+	mBarCounts[0] = 0;
+	mBarCounts[1] = 0;
+	mInputs[0].resize(INPUT_HISTORY);
+	mInputs[1].resize(INPUT_HISTORY);
+	mLastRemoteInput = PlayerInput();
+	mTick = 0;
+	mConfirmedTick = 0;
+	mRollbackTick = -1;
+	mRemoteAck = 0;
+	mSnapshots.resize(TOTAL_SNAPSHOTS);
+	for (int i = 0; i < TOTAL_SNAPSHOTS; ++i)
+	{
+		mSnapshotChecksums[i] = 0;
+	}
+	for (int i = 0; i < CHECKSUM_HISTORY; ++i)
+	{
+		mChecksumTicks[i] = -1;
+		mChecksums[i] = 0;
+	}
+	mNextChecksumTick = NETPLAY_CHECKSUM_INTERVAL;
+	mLatestChecksumEntry = -1;
+	mRemoteChecksumTick = -1;
+	mRemoteChecksum = 0;
+	mComparedChecksumTick = -1;
+	mIsDesynced = false;
+	mFinalChecksum = 0;
+	mStats = RollbackStats();
+}
+
+bool RollbackSession::start(Match* match, int localPlayer, NetTransport* transport, Uint32 matchId)
+{
+	stop();
+
+	//Find each player's bars, in the same order on both peers since they play the same arena
+	EntityStore& entities = match->getEntities();
+	mBarCounts[0] = 0;
+	mBarCounts[1] = 0;
+	for (int i = 0; i < entities.getBarCount(); ++i)
+	{
+		int player = entities.barPlayer[i] - 1;
+		if (player < 0 || player > 1)
+		{
+			continue;
+		}
+		if (mBarCounts[player] == MAX_PLAYER_BARS)
+		{
+			printf("Netplay supports up to %d bars per player!\n", MAX_PLAYER_BARS);
+			return false;
+		}
+		mBarIndices[player][mBarCounts[player]] = i;
+		mBarCounts[player] += 1;
+	}
+
+	mMatch = match;
+	mTransport = transport;
+
+	//Sizes every snapshot up front, so neither ticks nor rollbacks allocate from here on
+	for (int i = 0; i < TOTAL_SNAPSHOTS; ++i)
+	{
+		mMatch->saveSnapshot(mSnapshots[i]);
+	}
+	mLocalPlayer = localPlayer;
+	mRemotePlayer = localPlayer == 1 ? 2 : 1;
+	mMatchId = matchId;
+
+	//Until the remote's first input arrives they're predicted to leave their bars as the reset put them
+	mLastRemoteInput = captureInput(mRemotePlayer);
+	mTick = 0;
+	mConfirmedTick = 0;
+	mRollbackTick = -1;
+	mRemoteAck = 0;
+	for (int i = 0; i < CHECKSUM_HISTORY; ++i)
+	{
+		mChecksumTicks[i] = -1;
+	}
+	mNextChecksumTick = NETPLAY_CHECKSUM_INTERVAL;
+	mLatestChecksumEntry = -1;
+	mRemoteChecksumTick = -1;
+	mComparedChecksumTick = -1;
+	mIsDesynced = false;
+	mFinalChecksum = 0;
+	mStats = RollbackStats();
+	return true;
+}
+
+void RollbackSession::stop()
+{
+	mMatch = NULL;
+	mTransport = NULL;
+}
+
+bool RollbackSession::advance()
+{
+	if (mMatch == NULL)
+	{
+		return false;
+	}
+
+	//Taken before a rollback can overwrite the bars
+	PlayerInput localInput = captureInput(mLocalPlayer);
+
+	receivePackets();
+	if (mRollbackTick >= 0)
+	{
+		rollBack();
+	}
+
+	bool isStalled = mTick - mConfirmedTick >= MAX_ROLLBACK_TICKS;
+	bool isTicking = !isStalled && !mMatch->isOver();
+	if (isTicking)
+	{
+		mInputs[mLocalPlayer - 1][mTick % INPUT_HISTORY] = localInput;
+		simulateTick(mTick);
+		mTick += 1;
+	}
+	else
+	{
+		//Keep what the player pressed in the meantime, it goes in with the next tick played
+		applyInput(mLocalPlayer, localInput);
+		if (isStalled && !mMatch->isOver())
+		{
+			mStats.stalledFrames += 1;
+		}
+	}
+
+	updateChecksums();
+	sendPacket();
+	return isTicking;
+}
+
+PlayerInput RollbackSession::captureInput(int player)
+{
+	EntityStore& entities = mMatch->getEntities();
+	PlayerInput input = PlayerInput();
+	for (int i = 0; i < mBarCounts[player - 1]; ++i)
+	{
+		int bar = mBarIndices[player - 1][i];
+		input.barVelY[i] = (Sint16)entities.barVelY[bar];
+		if (entities.barDisabled[bar])
+		{
+			input.disabledMask |= (Uint16)(1 << i);
+		}
+	}
+	return input;
+}
+
+void RollbackSession::applyInput(int player, const PlayerInput& input)
+{
+	EntityStore& entities = mMatch->getEntities();
+	for (int i = 0; i < mBarCounts[player - 1]; ++i)
+	{
+		int bar = mBarIndices[player - 1][i];
+		entities.barVelY[bar] = input.barVelY[i];
+		entities.barDisabled[bar] = (input.disabledMask >> i) & 1;
+	}
+}
+
+bool RollbackSession::isSameInput(int player, const PlayerInput& first, const PlayerInput& second)
+{
+	if (first.disabledMask != second.disabledMask)
+	{
+		return false;
+	}
+	for (int i = 0; i < mBarCounts[player - 1]; ++i)
+	{
+		if (first.barVelY[i] != second.barVelY[i])
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+void RollbackSession::simulateTick(int tick)
+{
+	//Past the confirmed tick the remote keeps their last real input, remembered so the real one can be checked against it
+	PlayerInput& remoteInput = mInputs[mRemotePlayer - 1][tick % INPUT_HISTORY];
+	if (tick >= mConfirmedTick)
+	{
+		remoteInput = mLastRemoteInput;
+	}
+
+	//The bars hold whatever was pressed since the last tick, so the snapshot is taken with this tick's inputs in place
+	//That way both peers, and a rollback playing the tick again, snapshot the same state
+	applyInput(mLocalPlayer, mInputs[mLocalPlayer - 1][tick % INPUT_HISTORY]);
+	applyInput(mRemotePlayer, remoteInput);
+
+	int slot = tick % TOTAL_SNAPSHOTS;
+	mMatch->saveSnapshot(mSnapshots[slot]);
+	if (tick % NETPLAY_CHECKSUM_INTERVAL == 0)
+	{
+		mSnapshotChecksums[slot] = mMatch->getChecksum();
+	}
+	mMatch->tick();
+
+	//A rollback plays the last tick again, so this ends up as the match really ended
+	if (mMatch->isOver())
+	{
+		mFinalChecksum = mMatch->getChecksum();
+	}
+}
+
+void RollbackSession::rollBack()
+{
+	TraceScope trace("Rollback");
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+	int firstTick = mRollbackTick;
+	mRollbackTick = -1;
+	mMatch->loadSnapshot(mSnapshots[firstTick % TOTAL_SNAPSHOTS]);
+	for (int tick = firstTick; tick < mTick; ++tick)
+	{
+		simulateTick(tick);
+	}
+
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	int totalTicks = mTick - firstTick;
+	mStats.rollbacks += 1;
+	mStats.resimulatedTicks += totalTicks;
+	mStats.longestRollback = std::max(mStats.longestRollback, totalTicks);
+	mStats.slowestRollbackSeconds = std::max(mStats.slowestRollbackSeconds, seconds);
+}
+
+void RollbackSession::receivePackets()
+{
+	Uint8 packet[MAX_PACKET_SIZE];
+	int size = 0;
+	while ((size = mTransport->receive(packet, MAX_PACKET_SIZE)) > 0)
+	{
+		readPacket(packet, size);
+	}
+}
+
+void RollbackSession::readPacket(const Uint8* packet, int size)
+{
+	if (size < PACKET_HEADER_SIZE)
+	{
+		return;
+	}
+
+	int offset = 0;
+	if (readUint32(packet, offset) != mMatchId)
+	{
+		return;
+	}
+	mStats.packetsReceived += 1;
+
+	//The remote can't have inputs we haven't played yet
+	int ack = (int)readUint32(packet, offset);
+	mRemoteAck = std::max(mRemoteAck, std::min(ack, mTick));
+
+	Uint32 checksum = readUint32(packet, offset);
+	int checksumTick = (int)readUint32(packet, offset);
+	if (checksumTick > mRemoteChecksumTick)
+	{
+		mRemoteChecksumTick = checksumTick;
+		mRemoteChecksum = checksum;
+		compareChecksums();
+	}
+
+	int firstTick = (int)readUint32(packet, offset);
+	int totalInputs = packet[offset++];
+	int barCount = mBarCounts[mRemotePlayer - 1];
+	if (size < offset + totalInputs * (2 + 2 * barCount))
+	{
+		return;
+	}
+
+	std::vector<PlayerInput>& remoteInputs = mInputs[mRemotePlayer - 1];
+	for (int i = 0; i < totalInputs; ++i)
+	{
+		PlayerInput input = PlayerInput();
+		input.disabledMask = readUint16(packet, offset);
+		for (int bar = 0; bar < barCount; ++bar)
+		{
+			input.barVelY[bar] = (Sint16)readUint16(packet, offset);
+		}
+
+		//Inputs are only taken in order, anything after a gap comes again in a later packet
+		//A peer never gets far enough ahead to wrap the history
+		int tick = firstTick + i;
+		if (tick < mConfirmedTick)
+		{
+			continue;
+		}
+		if (tick > mConfirmedTick || tick >= mTick + INPUT_HISTORY / 2)
+		{
+			break;
+		}
+
+		//A tick already played on a wrong guess has to be played again
+		if (tick < mTick && mRollbackTick < 0 && !isSameInput(mRemotePlayer, input, remoteInputs[tick % INPUT_HISTORY]))
+		{
+			mRollbackTick = tick;
+		}
+		remoteInputs[tick % INPUT_HISTORY] = input;
+		mLastRemoteInput = input;
+		mConfirmedTick += 1;
+	}
+}
+
+void RollbackSession::sendPacket()
+{
+	Uint8 packet[MAX_PACKET_SIZE];
+	int offset = 0;
+	writeUint32(packet, offset, mMatchId);
+	writeUint32(packet, offset, (Uint32)mConfirmedTick);
+
+	bool hasChecksum = mLatestChecksumEntry >= 0;
+	writeUint32(packet, offset, hasChecksum ? mChecksums[mLatestChecksumEntry] : 0);
+	writeUint32(packet, offset, (Uint32)(hasChecksum ? mChecksumTicks[mLatestChecksumEntry] : -1));
+
+	//Every input the remote hasn't got yet, as many as fit, so a lost packet is covered by the next one
+	int barCount = mBarCounts[mLocalPlayer - 1];
+	int inputSize = 2 + 2 * barCount;
+	int firstTick = std::max(mRemoteAck, mTick - INPUT_HISTORY);
+	int totalInputs = std::min(mTick - firstTick, std::min((MAX_PACKET_SIZE - PACKET_HEADER_SIZE) / inputSize, 255));
+	writeUint32(packet, offset, (Uint32)firstTick);
+	packet[offset++] = (Uint8)totalInputs;
+
+	const std::vector<PlayerInput>& localInputs = mInputs[mLocalPlayer - 1];
+	for (int i = 0; i < totalInputs; ++i)
+	{
+		const PlayerInput& input = localInputs[(firstTick + i) % INPUT_HISTORY];
+		writeUint16(packet, offset, input.disabledMask);
+		for (int bar = 0; bar < barCount; ++bar)
+		{
+			writeUint16(packet, offset, (Uint16)input.barVelY[bar]);
+		}
+	}
+
+	mTransport->send(packet, offset);
+	mStats.packetsSent += 1;
+}
+
+void RollbackSession::updateChecksums()
+{
+	//A snapshot is final once every input up to its own tick is real, and it's still kept while it's at most a window old
+	while (mNextChecksumTick < std::min(mConfirmedTick, mTick))
+	{
+		int tick = mNextChecksumTick;
+		mNextChecksumTick += NETPLAY_CHECKSUM_INTERVAL;
+		if (tick < mTick - TOTAL_SNAPSHOTS)
+		{
+			continue;
+		}
+
+		int entry = (tick / NETPLAY_CHECKSUM_INTERVAL - 1) % CHECKSUM_HISTORY;
+		mChecksumTicks[entry] = tick;
+		mChecksums[entry] = mSnapshotChecksums[tick % TOTAL_SNAPSHOTS];
+		mLatestChecksumEntry = entry;
+		compareChecksums();
+	}
+}
+
+void RollbackSession::compareChecksums()
+{
+	if (mRemoteChecksumTick < NETPLAY_CHECKSUM_INTERVAL)
+	{
+		return;
+	}
+
+	//Each tick is checked once, as soon as both sides have it
+	int entry = (mRemoteChecksumTick / NETPLAY_CHECKSUM_INTERVAL - 1) % CHECKSUM_HISTORY;
+	if (mChecksumTicks[entry] != mRemoteChecksumTick || mRemoteChecksumTick <= mComparedChecksumTick)
+	{
+		return;
+	}
+	mComparedChecksumTick = mRemoteChecksumTick;
+	mStats.checksumsCompared += 1;
+	if (mChecksums[entry] != mRemoteChecksum)
+	{
+		mIsDesynced = true;
+	}
+}
+
+bool RollbackSession::isRunning()
+{
+	return mMatch != NULL;
+}
+
+int RollbackSession::getLocalPlayer()
+{
+	return mLocalPlayer;
+}
+
+bool RollbackSession::isFinished()
+{
+	return mMatch != NULL && mMatch->isOver() && mConfirmedTick >= mMatch->getTickCount();
+}
+
+Uint32 RollbackSession::getFinalChecksum()
+{
+	return mFinalChecksum;
+}
+
+bool RollbackSession::isDesynced()
+{
+	return mIsDesynced;
+}
+
+int RollbackSession::getTick()
+{
+	return mTick;
+}
+
+int RollbackSession::getConfirmedTick()
+{
+	return mConfirmedTick;
+}
+
+RollbackStats& RollbackSession::getStats()
+{
+	return mStats;
+}
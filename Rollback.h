@@ -0,0 +1,163 @@
+#pragma once
+#include <SDL.h>
+#include <vector>
+#include "Match.h"
+#include "NetTransport.h"
+
+//Most bars one player can have in a netplay match
+const int MAX_PLAYER_BARS = 16;
+
+//Ticks a peer may play ahead of the other peer's last known input, each of them may have to be played again
+const int MAX_ROLLBACK_TICKS = 8;
+
+//Ticks between the checksums the peers compare to find a desync
+const int NETPLAY_CHECKSUM_INTERVAL = 30;
+
+//What one player did in a tick, the velocity and enabled state of each of their bars
+//Keys, bots and mode switches all end up as bar state, so this covers every way of playing
+struct PlayerInput
+{
+	//In the arena's order of the player's bars
+	Sint16 barVelY[MAX_PLAYER_BARS];
+	Uint16 disabledMask;
+};
+
+//How often and how far a session had to roll back
+struct RollbackStats
+{
+	//Wrong predictions, and the ticks played again to fix them
+	int rollbacks;
+	long long resimulatedTicks;
+	int longestRollback;
+	double slowestRollbackSeconds;
+
+	//Frames no tick was played because the other peer was too far behind
+	int stalledFrames;
+
+	int packetsSent;
+	int packetsReceived;
+
+	//Checksums of the same tick compared with the remote peer
+	int checksumsCompared;
+};
+
+//Plays one side of a match against a remote peer without waiting for their inputs
+//The remote player is predicted to keep doing what they last did, when their real input turns out different
+//the match is put back to that tick and played forward again, which takes a few microseconds per tick
+class RollbackSession
+{
+public:
+	//Ticks of inputs kept, enough for both peers to be a full rollback window apart
+	static const int INPUT_HISTORY = 64;
+
+	//Snapshots kept, one per tick that may still be rolled back to
+	static const int TOTAL_SNAPSHOTS = MAX_ROLLBACK_TICKS + 2;
+
+	//Initializes variables
+	RollbackSession();
+
+	//Starts playing a match that both peers set up and reset the same way
+	//Packets of other matches are ignored, so the peers should agree on a different match id for every match
+	//The match and transport have to outlive the session
+	bool start(Match* match, int localPlayer, NetTransport* transport, Uint32 matchId);
+
+	//Stops playing, the match stays as it is
+	void stop();
+
+	//Sends the local player's input as it is now and takes in the remote player's
+	//Rolls back if a prediction was wrong, then plays the next tick unless the other peer is too far behind
+	//Returns whether a tick was played
+	bool advance();
+
+	//Gets session state
+	bool isRunning();
+	int getLocalPlayer();
+
+	//Gets whether the match is over with every input that led there known
+	bool isFinished();
+
+	//Gets the checksum the match had right after its last tick, only meaningful once it's finished
+	//Players may still move their bars after that, so the match's own checksum can differ between the peers
+	Uint32 getFinalChecksum();
+
+	//Gets whether the peers' checksums of the same tick ever differed
+	bool isDesynced();
+
+	//Gets the next tick to be played, and how many ticks have the remote player's real input
+	int getTick();
+	int getConfirmedTick();
+
+	RollbackStats& getStats();
+
+private:
+	//Reads the player's input from their bars, or writes it to them
+	PlayerInput captureInput(int player);
+	void applyInput(int player, const PlayerInput& input);
+	bool isSameInput(int player, const PlayerInput& first, const PlayerInput& second);
+
+	//Puts in the local input and the remote's real or predicted one, snapshots the match, then plays the tick
+	void simulateTick(int tick);
+
+	//Loads the snapshot of the first mispredicted tick and plays forward to where the match was
+	void rollBack();
+
+	//Takes in every packet that arrived
+	void receivePackets();
+	void readPacket(const Uint8* packet, int size);
+
+	//Sends the local inputs the remote hasn't acknowledged yet
+	void sendPacket();
+
+	//Takes the checksums of snapshots that can't change anymore
+	void updateChecksums();
+	void compareChecksums();
+
+	Match* mMatch;
+	NetTransport* mTransport;
+	int mLocalPlayer;
+	int mRemotePlayer;
+	Uint32 mMatchId;
+
+	//Entity index of each player's bars, by player - 1
+	int mBarIndices[2][MAX_PLAYER_BARS];
+	int mBarCounts[2];
+
+	//Inputs of both players by tick, the remote's past the confirmed tick are predictions
+	std::vector<PlayerInput> mInputs[2];
+
+	//Latest real input of the remote player, what it's predicted to stay at
+	PlayerInput mLastRemoteInput;
+
+	//Next tick to play, ticks before mConfirmedTick have the remote's real input
+	int mTick;
+	int mConfirmedTick;
+
+	//Earliest tick whose prediction was wrong, -1 if none
+	int mRollbackTick;
+
+	//Remote's count of our inputs it has
+	int mRemoteAck;
+
+	//Match at the start of each recent tick, and its checksum on checksum ticks
+	std::vector<MatchSnapshot> mSnapshots;
+	Uint32 mSnapshotChecksums[TOTAL_SNAPSHOTS];
+
+	//Our latest checksums and the remote's latest one, for ticks that can't change anymore
+	static const int CHECKSUM_HISTORY = 8;
+	int mChecksumTicks[CHECKSUM_HISTORY];
+	Uint32 mChecksums[CHECKSUM_HISTORY];
+	int mNextChecksumTick;
+
+	//Entry of the checksum taken last, the one sent to the remote, -1 until the first is taken
+	int mLatestChecksumEntry;
+
+	int mRemoteChecksumTick;
+	Uint32 mRemoteChecksum;
+	int mComparedChecksumTick;
+	bool mIsDesynced;
+
+	//Checksum after the latest tick that ended the match
+	Uint32 mFinalChecksum;
+
+	RollbackStats mStats;
+};
@@ -1,4 +1,5 @@
 #include "ScoreCounter.h"
+#include <algorithm>
 
 ScoreCounter::ScoreCounter()
 {
@@ -21,3 +22,37 @@ void ScoreCounter::plusScore(int pId)
 		p2Score += 1;
 	}
 }
+
+int ScoreCounter::getScore(int pId) {
+	if (pId == 1) {
+		return p1Score;
+	}
+	if (pId == 2) {
+		return p2Score;
+	}
+	return 0;
+}
+
+int ScoreCounter::getHigherScorePlayer() {
+	if (p1Score > p2Score) {
+		return 1;
+	}
+	if (p1Score < p2Score) {
+		return 2;
+	}
+	return 0;
+}
+
+int ScoreCounter::getVictoryPlayer() {
+	if (p1Score == 3) {
+		return 1;
+	}
+	if (p2Score == 3) {
+		return 2;
+	}
+	return 0;
+}
+
+int ScoreCounter::getStage() {
+	return std::min(p1Score, p2Score) + 1;
+}
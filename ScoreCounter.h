@@ -10,10 +10,13 @@ public:
     void reset();
     void plusScore(int pId);
 
-    //render
-    void render();
+    //Gets match standing
+    int getScore(int pId);
+    int getHigherScorePlayer();
+    int getVictoryPlayer();
+    int getStage();
 
 private:
     //The clock time when the timer started
     int p1Score, p2Score;
-};
\ No newline at end of file
+};
@@ -0,0 +1,257 @@
+#include "SpatialGrid.h"
+#include <algorithm>
+
+//Range of an item that isn't in the grid
+static const int NO_CELL = -1;
+
+void GridLayout::init(int width, int height, int cellSize)
+{
+	cellShift = 0;
+	while ((1 << cellShift) < cellSize)
+	{
+		cellShift += 1;
+	}
+	int roundedSize = 1 << cellShift;
+	columns = std::max((width + roundedSize - 1) / roundedSize, 1);
+	rows = std::max((height + roundedSize - 1) / roundedSize, 1);
+}
+
+GridCellRange GridLayout::getRange(const SDL_Rect& box) const
+{
+	//The far edges count as part of the box, so a range never misses a cell the box reaches into
+	GridCellRange range;
+	range.minX = std::min(std::max(box.x, 0) >> cellShift, columns - 1);
+	range.minY = std::min(std::max(box.y, 0) >> cellShift, rows - 1);
+	range.maxX = std::min(std::max(box.x + box.w, 0) >> cellShift, columns - 1);
+	range.maxY = std::min(std::max(box.y + box.h, 0) >> cellShift, rows - 1);
+	return range;
+}
+
+//Puts items gathered from several cells in ascending order and drops the repeats, returns how many are left
+//There are only ever a few, insertion sort beats std::sort on those
+static int sortUniqueItems(int* items, int totalItems)
+{
+	for (int i = 1; i < totalItems; ++i)
+	{
+		int item = items[i];
+		int j = i;
+		for (; j > 0 && items[j - 1] > item; --j)
+		{
+			items[j] = items[j - 1];
+		}
+		items[j] = item;
+	}
+	return (int)(std::unique(items, items + totalItems) - items);
+}
+
+SpatialGrid::SpatialGrid()
+{
+	mLayout.init(1, 1, 1);
+	mQueryStamp = 0;
+}
+
+void SpatialGrid::reset(int width, int height, int cellSize, int maxItems)
+{
+	mLayout.init(width, height, cellSize);
+	mCells.assign(mLayout.columns * mLayout.rows, std::vector<int>());
+	for (size_t i = 0; i < mCells.size(); ++i)
+	{
+		mCells[i].reserve(maxItems);
+	}
+
+	GridCellRange absent = { 0, 0, NO_CELL, NO_CELL };
+	SDL_Rect noBox = { 0, 0, -1, -1 };
+	mItemBoxes.assign(maxItems, noBox);
+	mItemRanges.assign(maxItems, absent);
+	mItemStamps.assign(maxItems, 0);
+	mQueryStamp = 0;
+}
+
+void SpatialGrid::update(int item, const SDL_Rect& box)
+{
+	SDL_Rect& lastBox = mItemBoxes[item];
+	if (box.x == lastBox.x && box.y == lastBox.y && box.w == lastBox.w && box.h == lastBox.h)
+	{
+		return;
+	}
+	lastBox = box;
+
+	GridCellRange range = mLayout.getRange(box);
+	GridCellRange& current = mItemRanges[item];
+	if (range.minX == current.minX && range.minY == current.minY && range.maxX == current.maxX && range.maxY == current.maxY)
+	{
+		return;
+	}
+
+	removeRange(item, current);
+	insertRange(item, range);
+	current = range;
+}
+
+void SpatialGrid::remove(int item)
+{
+	GridCellRange& current = mItemRanges[item];
+	removeRange(item, current);
+	current.minX = 0;
+	current.maxX = NO_CELL;
+	mItemBoxes[item].w = -1;
+}
+
+int SpatialGrid::query(const SDL_Rect& box, int* items)
+{
+	//New stamp for this query, clear the old ones once it wraps around
+	mQueryStamp += 1;
+	if (mQueryStamp == 0)
+	{
+		std::fill(mItemStamps.begin(), mItemStamps.end(), 0);
+		mQueryStamp = 1;
+	}
+
+	//Most boxes sit in a single cell, whose items are already sorted and unique
+	GridCellRange range = mLayout.getRange(box);
+	if (range.minX == range.maxX && range.minY == range.maxY)
+	{
+		const std::vector<int>& cell = mCells[range.minY * mLayout.columns + range.minX];
+		std::copy(cell.begin(), cell.end(), items);
+		return (int)cell.size();
+	}
+
+	int totalItems = 0;
+	for (int y = range.minY; y <= range.maxY; ++y)
+	{
+		for (int x = range.minX; x <= range.maxX; ++x)
+		{
+			const std::vector<int>& cell = mCells[y * mLayout.columns + x];
+			for (size_t i = 0; i < cell.size(); ++i)
+			{
+				int item = cell[i];
+				if (mItemStamps[item] != mQueryStamp)
+				{
+					mItemStamps[item] = mQueryStamp;
+					items[totalItems++] = item;
+				}
+			}
+		}
+	}
+
+	//Callers visit candidates in the same order a loop over every item would
+	return sortUniqueItems(items, totalItems);
+}
+
+int SpatialGrid::getMaxItems() const
+{
+	return (int)mItemRanges.size();
+}
+
+void SpatialGrid::insertRange(int item, const GridCellRange& range)
+{
+	for (int y = range.minY; y <= range.maxY; ++y)
+	{
+		for (int x = range.minX; x <= range.maxX; ++x)
+		{
+			std::vector<int>& cell = mCells[y * mLayout.columns + x];
+			cell.insert(std::lower_bound(cell.begin(), cell.end(), item), item);
+		}
+	}
+}
+
+void SpatialGrid::removeRange(int item, const GridCellRange& range)
+{
+	for (int y = range.minY; y <= range.maxY; ++y)
+	{
+		for (int x = range.minX; x <= range.maxX; ++x)
+		{
+			std::vector<int>& cell = mCells[y * mLayout.columns + x];
+			std::vector<int>::iterator found = std::find(cell.begin(), cell.end(), item);
+			if (found != cell.end())
+			{
+				cell.erase(found);
+			}
+		}
+	}
+}
+
+StaticGrid::StaticGrid()
+{
+	mLayout.init(1, 1, 1);
+	mCellStarts.assign(2, 0);
+	mTotalItems = 0;
+}
+
+void StaticGrid::build(const std::vector<SDL_Rect>& boxes, int width, int height, int cellSize)
+{
+	mLayout.init(width, height, cellSize);
+	int totalCells = mLayout.columns * mLayout.rows;
+	mTotalItems = (int)boxes.size();
+
+	//Count the boxes in each cell, then turn the counts into where each cell starts
+	mCellStarts.assign(totalCells + 1, 0);
+	mItemRanges.resize(mTotalItems);
+	for (int i = 0; i < mTotalItems; ++i)
+	{
+		GridCellRange range = mLayout.getRange(boxes[i]);
+		mItemRanges[i] = range;
+		for (int y = range.minY; y <= range.maxY; ++y)
+		{
+			for (int x = range.minX; x <= range.maxX; ++x)
+			{
+				mCellStarts[y * mLayout.columns + x + 1] += 1;
+			}
+		}
+	}
+	for (int cell = 0; cell < totalCells; ++cell)
+	{
+		mCellStarts[cell + 1] += mCellStarts[cell];
+	}
+
+	//Filing the boxes in index order leaves every cell sorted
+	mCellItems.assign(mCellStarts[totalCells], 0);
+	std::vector<int> filled(mCellStarts.begin(), mCellStarts.end() - 1);
+	for (int i = 0; i < mTotalItems; ++i)
+	{
+		const GridCellRange& range = mItemRanges[i];
+		for (int y = range.minY; y <= range.maxY; ++y)
+		{
+			for (int x = range.minX; x <= range.maxX; ++x)
+			{
+				mCellItems[filled[y * mLayout.columns + x]++] = i;
+			}
+		}
+	}
+}
+
+int StaticGrid::query(const SDL_Rect& box, int* items) const
+{
+	GridCellRange range = mLayout.getRange(box);
+	int totalItems = 0;
+	for (int y = range.minY; y <= range.maxY; ++y)
+	{
+		for (int x = range.minX; x <= range.maxX; ++x)
+		{
+			int cell = y * mLayout.columns + x;
+			for (int i = mCellStarts[cell]; i < mCellStarts[cell + 1]; ++i)
+			{
+				//An item in several of the cells is only written from the first one both ranges share
+				//Nothing is written twice, so the output never outgrows the item count
+				int item = mCellItems[i];
+				const GridCellRange& itemRange = mItemRanges[item];
+				if (x == std::max(itemRange.minX, range.minX) && y == std::max(itemRange.minY, range.minY))
+				{
+					items[totalItems++] = item;
+				}
+			}
+		}
+	}
+
+	//A single cell is already sorted, several are unique but gathered cell by cell
+	if (range.minX == range.maxX && range.minY == range.maxY)
+	{
+		return totalItems;
+	}
+	return sortUniqueItems(items, totalItems);
+}
+
+int StaticGrid::getItemCount() const
+{
+	return mTotalItems;
+}
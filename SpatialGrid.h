@@ -0,0 +1,103 @@
+#pragma once
+#include <SDL.h>
+#include <vector>
+
+//Cells a box covers, inclusive, empty when minX > maxX
+struct GridCellRange
+{
+	int minX, minY, maxX, maxY;
+};
+
+//How an area is split into square cells, boxes reaching outside the area land in the edge cells
+struct GridLayout
+{
+	//Grid size in cells
+	int columns;
+	int rows;
+
+	//Cells are 1 << cellShift pixels wide
+	int cellShift;
+
+	//Splits the area into cells of at least cellSize
+	//The size is rounded up to a power of two, so cells are found with shifts instead of divisions
+	void init(int width, int height, int cellSize);
+
+	//Gets the cells a box covers
+	GridCellRange getRange(const SDL_Rect& box) const;
+};
+
+//Uniform grid broadphase, finds the items whose boxes might overlap a box
+//Items are small integers, like obstacle indices, and stay in the cells their box covers
+//Moving an item only touches cells when it covers different ones than before, and a box that didn't change costs a compare
+class SpatialGrid
+{
+public:
+	//Initializes an empty grid
+	SpatialGrid();
+
+	//Splits the area into cells and empties them
+	//Every cell reserves room for all items, so updates never allocate
+	void reset(int width, int height, int cellSize, int maxItems);
+
+	//Inserts an item or moves it to a new box
+	void update(int item, const SDL_Rect& box);
+
+	//Takes an item out of the grid
+	void remove(int item);
+
+	//Writes every item in the cells the box covers, once each and in ascending order
+	//Returns how many were written, items needs room for getMaxItems of them
+	int query(const SDL_Rect& box, int* items);
+
+	//Gets the number of item slots
+	int getMaxItems() const;
+
+private:
+	void insertRange(int item, const GridCellRange& range);
+	void removeRange(int item, const GridCellRange& range);
+
+	GridLayout mLayout;
+
+	//Items in each cell in ascending order, row by row
+	std::vector<std::vector<int>> mCells;
+
+	//Box each item was last updated with and the cells it's in
+	std::vector<SDL_Rect> mItemBoxes;
+	std::vector<GridCellRange> mItemRanges;
+
+	//Query an item was last reported in, so items in several cells are reported once
+	//Only needed for boxes covering more than one cell
+	std::vector<Uint32> mItemStamps;
+	Uint32 mQueryStamp;
+};
+
+//Grid of boxes that never move, built once
+//Nothing changes after building, so any number of threads can query it at the same time
+class StaticGrid
+{
+public:
+	//Initializes an empty grid
+	StaticGrid();
+
+	//Splits the area into cells and files every box, box i becomes item i
+	void build(const std::vector<SDL_Rect>& boxes, int width, int height, int cellSize);
+
+	//Writes every item in the cells the box covers, once each and in ascending order
+	//An item is only written from the first of its cells the box covers, so items needs room for no more than getItemCount of them
+	int query(const SDL_Rect& box, int* items) const;
+
+	//Gets the number of boxes built with
+	int getItemCount() const;
+
+private:
+	GridLayout mLayout;
+
+	//Items of cell i are mCellItems[mCellStarts[i]] up to mCellItems[mCellStarts[i + 1]], in ascending order
+	std::vector<int> mCellStarts;
+	std::vector<int> mCellItems;
+
+	//Cells each item is in
+	std::vector<GridCellRange> mItemRanges;
+
+	int mTotalItems;
+};
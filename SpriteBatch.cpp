@@ -0,0 +1,141 @@
+#include "SpriteBatch.h"
+#include <algorithm>
+#include "Profiler.h"
+
+SpriteBatch::SpriteBatch()
+{
+	mRenderer = NULL;
+	mDrawCalls = 0;
+	mSpriteCount = 0;
+}
+
+void SpriteBatch::begin(SDL_Renderer* renderer)
+{
+	mRenderer = renderer;
+	mSprites.clear();
+}
+
+void SpriteBatch::draw(LTexture& texture, int x, int y, SDL_Rect* clip, int layer)
+{
+	SDL_Texture* handle = texture.getTexture();
+	if (handle == NULL)
+	{
+		return;
+	}
+
+	//Whole image unless clipped, clips are relative to the image's region of the hardware texture
+	SDL_Rect source = texture.getRegion();
+	if (clip != NULL)
+	{
+		source = { source.x + clip->x, source.y + clip->y, clip->w, clip->h };
+	}
+
+	int textureWidth, textureHeight;
+	texture.getTextureSize(textureWidth, textureHeight);
+	SDL_FRect uv = {
+		(float)source.x / textureWidth,
+		(float)source.y / textureHeight,
+		(float)source.w / textureWidth,
+		(float)source.h / textureHeight
+	};
+	SDL_Rect dest = { x, y, source.w, source.h };
+
+	//Vertex colors stand in for the texture's modulation
+	SDL_Color color;
+	SDL_GetTextureColorMod(handle, &color.r, &color.g, &color.b);
+	SDL_GetTextureAlphaMod(handle, &color.a);
+
+	draw(handle, uv, dest, color, layer);
+}
+
+void SpriteBatch::draw(SDL_Texture* texture, const SDL_FRect& uv, const SDL_Rect& dest, SDL_Color color, int layer)
+{
+	Sprite sprite;
+	sprite.texture = texture;
+	SDL_GetTextureBlendMode(texture, &sprite.blendMode);
+	sprite.layer = layer;
+	sprite.uv = uv;
+	sprite.dest = dest;
+	sprite.color = color;
+	mSprites.push_back(sprite);
+}
+
+bool SpriteBatch::isDrawnBefore(const Sprite& a, const Sprite& b)
+{
+	if (a.layer != b.layer)
+	{
+		return a.layer < b.layer;
+	}
+	if (a.blendMode != b.blendMode)
+	{
+		return a.blendMode < b.blendMode;
+	}
+	return a.texture < b.texture;
+}
+
+void SpriteBatch::end()
+{
+	mDrawCalls = 0;
+	mSpriteCount = (int)mSprites.size();
+
+	std::stable_sort(mSprites.begin(), mSprites.end(), isDrawnBefore);
+
+	//Submit each run of quads sharing a texture
+	size_t runStart = 0;
+	while (runStart < mSprites.size())
+	{
+		size_t runEnd = runStart + 1;
+		while (runEnd < mSprites.size()
+			&& mSprites[runEnd].texture == mSprites[runStart].texture
+			&& mSprites[runEnd].layer == mSprites[runStart].layer)
+		{
+			runEnd += 1;
+		}
+
+		mVertices.clear();
+		for (size_t i = runStart; i < runEnd; ++i)
+		{
+			const Sprite& sprite = mSprites[i];
+			float left = (float)sprite.dest.x;
+			float top = (float)sprite.dest.y;
+			float right = left + sprite.dest.w;
+			float bottom = top + sprite.dest.h;
+			float u0 = sprite.uv.x;
+			float v0 = sprite.uv.y;
+			float u1 = sprite.uv.x + sprite.uv.w;
+			float v1 = sprite.uv.y + sprite.uv.h;
+
+			//Four corners of the sprite quad
+			mVertices.push_back({ { left, top }, sprite.color, { u0, v0 } });
+			mVertices.push_back({ { right, top }, sprite.color, { u1, v0 } });
+			mVertices.push_back({ { right, bottom }, sprite.color, { u1, v1 } });
+			mVertices.push_back({ { left, bottom }, sprite.color, { u0, v1 } });
+		}
+
+		//Grow the shared quad index list when a longer run shows up
+		int totalQuads = (int)(runEnd - runStart);
+		for (int quad = (int)mIndices.size() / 6; quad < totalQuads; ++quad)
+		{
+			int first = quad * 4;
+			int quadIndices[6] = { first, first + 1, first + 2, first, first + 2, first + 3 };
+			mIndices.insert(mIndices.end(), quadIndices, quadIndices + 6);
+		}
+
+		SDL_RenderGeometry(mRenderer, mSprites[runStart].texture, mVertices.data(), (int)mVertices.size(), mIndices.data(), totalQuads * 6);
+		mDrawCalls += 1;
+		runStart = runEnd;
+	}
+
+	gProfiler.countDrawCalls(mDrawCalls);
+	mSprites.clear();
+}
+
+int SpriteBatch::getDrawCalls()
+{
+	return mDrawCalls;
+}
+
+int SpriteBatch::getSpriteCount()
+{
+	return mSpriteCount;
+}
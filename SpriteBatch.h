@@ -0,0 +1,59 @@
+#pragma once
+#include <SDL.h>
+#include <vector>
+#include "LTexture.h"
+
+//Collects textured quads over a frame and submits them with one SDL_RenderGeometry call per texture
+//Quads are sorted by layer, then blend mode and texture, quads of one texture keep their order
+//Rotation and flipping are not supported, use LTexture::render for those
+class SpriteBatch
+{
+public:
+	//Initializes variables
+	SpriteBatch();
+
+	//Starts collecting quads for the renderer
+	void begin(SDL_Renderer* renderer);
+
+	//Adds the texture, or a clip of it, with its top left corner at given point
+	//Color and alpha modulation of the texture apply, lower layers are drawn first
+	void draw(LTexture& texture, int x, int y, SDL_Rect* clip = NULL, int layer = 0);
+
+	//Adds a quad with texture coordinates from 0 to 1
+	void draw(SDL_Texture* texture, const SDL_FRect& uv, const SDL_Rect& dest, SDL_Color color, int layer = 0);
+
+	//Sorts and submits everything collected since begin
+	void end();
+
+	//Gets what the last end submitted
+	int getDrawCalls();
+	int getSpriteCount();
+
+private:
+	struct Sprite
+	{
+		SDL_Texture* texture;
+		SDL_BlendMode blendMode;
+		int layer;
+
+		//Texture coordinates, screen quad and vertex color
+		SDL_FRect uv;
+		SDL_Rect dest;
+		SDL_Color color;
+	};
+
+	//Orders sprites by layer, blend mode and texture
+	static bool isDrawnBefore(const Sprite& a, const Sprite& b);
+
+	SDL_Renderer* mRenderer;
+
+	//Quads of the current frame
+	std::vector<Sprite> mSprites;
+
+	//Storage reused between frames
+	std::vector<SDL_Vertex> mVertices;
+	std::vector<int> mIndices;
+
+	int mDrawCalls;
+	int mSpriteCount;
+};
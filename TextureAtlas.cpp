@@ -0,0 +1,182 @@
+#include "TextureAtlas.h"
+#include <stdio.h>
+#include <algorithm>
+#include "TraceRecorder.h"
+#include "AllocationTracker.h"
+
+TextureAtlas::TextureAtlas()
+{
+}
+
+TextureAtlas::~TextureAtlas()
+{
+	//Deallocate
+	free();
+}
+
+bool TextureAtlas::addImage(const std::string& path)
+{
+	TraceScope trace("Decode image");
+
+	SDL_Surface* loadedSurface = IMG_Load(path.c_str());
+	if (loadedSurface == NULL)
+	{
+		printf("Unable to load image %s! SDL_image Error: %s\n", path.c_str(), IMG_GetError());
+		return false;
+	}
+
+	//Color key image
+	SDL_SetColorKey(loadedSurface, SDL_TRUE, SDL_MapRGB(loadedSurface->format, 0, 0xFF, 0xFF));
+
+	addSurface(path, loadedSurface);
+	return true;
+}
+
+void TextureAtlas::addSurface(const std::string& path, SDL_Surface* surface)
+{
+	Image image;
+	image.path = path;
+	image.surface = surface;
+	image.page = 0;
+	image.region = { 0, 0, surface->w, surface->h };
+	mImages.push_back(image);
+}
+
+bool TextureAtlas::isTaller(const Image* a, const Image* b)
+{
+	return a->surface->h > b->surface->h;
+}
+
+bool TextureAtlas::pack()
+{
+	TraceScope trace("Pack atlas");
+
+	std::vector<Image*> order;
+	for (size_t i = 0; i < mImages.size(); ++i)
+	{
+		order.push_back(&mImages[i]);
+	}
+	std::stable_sort(order.begin(), order.end(), isTaller);
+
+	//Place images on shelves, left to right, opening a new shelf or page when one runs out
+	int maxPageSize = MAX_PAGE_SIZE;
+	std::vector<SDL_Point> pageSizes;
+	int penX = 0;
+	int shelfY = 0;
+	int shelfHeight = 0;
+	for (size_t i = 0; i < order.size(); ++i)
+	{
+		Image& image = *order[i];
+		int cellWidth = image.region.w + 2 * PADDING;
+		int cellHeight = image.region.h + 2 * PADDING;
+
+		if (pageSizes.empty() || penX + cellWidth > maxPageSize)
+		{
+			shelfY += shelfHeight;
+			penX = 0;
+			shelfHeight = 0;
+		}
+		if (pageSizes.empty() || shelfY + cellHeight > maxPageSize)
+		{
+			SDL_Point pageSize = { 0, 0 };
+			pageSizes.push_back(pageSize);
+			penX = 0;
+			shelfY = 0;
+			shelfHeight = 0;
+		}
+
+		image.page = (int)pageSizes.size() - 1;
+		image.region.x = penX + PADDING;
+		image.region.y = shelfY + PADDING;
+
+		penX += cellWidth;
+		shelfHeight = std::max(shelfHeight, cellHeight);
+
+		//Pages only grow as far as their images, oversized images make oversized pages
+		SDL_Point& pageSize = pageSizes.back();
+		pageSize.x = std::max(pageSize.x, penX);
+		pageSize.y = std::max(pageSize.y, shelfY + cellHeight);
+	}
+
+	//Copy the images into one surface per page and upload it
+	bool success = true;
+	for (size_t page = 0; page < pageSizes.size(); ++page)
+	{
+		SDL_Surface* pageSurface = SDL_CreateRGBSurfaceWithFormat(0, pageSizes[page].x, pageSizes[page].y, 32, SDL_PIXELFORMAT_RGBA32);
+		if (pageSurface == NULL)
+		{
+			printf("Unable to create atlas page! SDL Error: %s\n", SDL_GetError());
+			success = false;
+			break;
+		}
+		AllocationTracker::countSurface();
+
+		//Starts out fully transparent
+		SDL_FillRect(pageSurface, NULL, 0);
+		for (size_t i = 0; i < mImages.size(); ++i)
+		{
+			Image& image = mImages[i];
+			if (image.page != (int)page)
+			{
+				continue;
+			}
+
+			//Copy alpha as it is, color keyed pixels are skipped and stay transparent
+			SDL_SetSurfaceBlendMode(image.surface, SDL_BLENDMODE_NONE);
+			SDL_Rect destination = image.region;
+			SDL_BlitSurface(image.surface, NULL, pageSurface, &destination);
+		}
+
+		TextureHandle pageTexture = std::make_shared<LTexture>();
+		if (!pageTexture->loadFromSurface(pageSurface))
+		{
+			success = false;
+		}
+		SDL_FreeSurface(pageSurface);
+		mPages.push_back(pageTexture);
+	}
+
+	//Hand out the regions
+	for (size_t i = 0; i < mImages.size() && success; ++i)
+	{
+		Image& image = mImages[i];
+		TextureHandle texture = std::make_shared<LTexture>();
+		texture->setAtlasRegion(mPages[image.page], image.region);
+		mTextures[image.path] = texture;
+	}
+
+	//The pixels live on the pages now
+	for (size_t i = 0; i < mImages.size(); ++i)
+	{
+		SDL_FreeSurface(mImages[i].surface);
+	}
+	mImages.clear();
+
+	return success;
+}
+
+TextureHandle TextureAtlas::getTexture(const std::string& path)
+{
+	std::map<std::string, TextureHandle>::iterator packed = mTextures.find(path);
+	if (packed == mTextures.end())
+	{
+		return TextureHandle();
+	}
+	return packed->second;
+}
+
+int TextureAtlas::getPageCount()
+{
+	return (int)mPages.size();
+}
+
+void TextureAtlas::free()
+{
+	for (size_t i = 0; i < mImages.size(); ++i)
+	{
+		SDL_FreeSurface(mImages[i].surface);
+	}
+	mImages.clear();
+	mTextures.clear();
+	mPages.clear();
+}
@@ -0,0 +1,63 @@
+#pragma once
+#include <map>
+#include <string>
+#include <vector>
+#include "LTexture.h"
+
+//Packs images into as few textures as possible at startup, each image is handed out as a region of its page
+//Sprites sharing a page batch into one draw call
+class TextureAtlas
+{
+public:
+	//Largest page, bigger images get a page of their own
+	static const int MAX_PAGE_SIZE = 1024;
+
+	//Empty pixels around every image so filtering never picks up a neighbour
+	static const int PADDING = 1;
+
+	//Initializes variables
+	TextureAtlas();
+
+	//Deallocates memory
+	~TextureAtlas();
+
+	//Decodes an image to be packed, color keyed the same way as LTexture::loadFromFile
+	bool addImage(const std::string& path);
+
+	//Adds an already decoded image to be packed, the atlas frees the surface
+	void addSurface(const std::string& path, SDL_Surface* surface);
+
+	//Packs the added images into pages and uploads them
+	bool pack();
+
+	//Gets the texture of a packed image, an empty handle if it isn't in the atlas
+	TextureHandle getTexture(const std::string& path);
+
+	//Gets the number of uploaded pages
+	int getPageCount();
+
+	//Deallocates images and pages, textures handed out keep their page alive
+	void free();
+
+private:
+	struct Image
+	{
+		std::string path;
+		SDL_Surface* surface;
+
+		//Where the image goes
+		int page;
+		SDL_Rect region;
+	};
+
+	//Orders images by height for shelf packing, tallest first
+	static bool isTaller(const Image* a, const Image* b);
+
+	//Images waiting to be packed
+	std::vector<Image> mImages;
+
+	std::vector<TextureHandle> mPages;
+
+	//Packed images by path
+	std::map<std::string, TextureHandle> mTextures;
+};
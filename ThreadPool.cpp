@@ -0,0 +1,129 @@
+#include "ThreadPool.h"
+
+ThreadPool::ThreadPool(int totalThreads)
+	: mQueuedJobs(0), mUnfinishedJobs(0), mStopping(false), mNextWorker(0)
+{
+	if (totalThreads <= 0)
+	{
+		totalThreads = (int)std::thread::hardware_concurrency();
+	}
+	if (totalThreads <= 0)
+	{
+		totalThreads = 1;
+	}
+
+	for (int i = 0; i < totalThreads; ++i)
+	{
+		mWorkers.push_back(std::unique_ptr<Worker>(new Worker()));
+	}
+	for (int i = 0; i < totalThreads; ++i)
+	{
+		mThreads.push_back(std::thread(&ThreadPool::workerLoop, this, i));
+	}
+}
+
+ThreadPool::~ThreadPool()
+{
+	wait();
+
+	{
+		std::lock_guard<std::mutex> lock(mSleepMutex);
+		mStopping = true;
+	}
+	mJobQueued.notify_all();
+
+	for (size_t i = 0; i < mThreads.size(); ++i)
+	{
+		mThreads[i].join();
+	}
+}
+
+void ThreadPool::submit(std::function<void()> job)
+{
+	mUnfinishedJobs += 1;
+
+	Worker& worker = *mWorkers[mNextWorker % mWorkers.size()];
+	mNextWorker += 1;
+	{
+		std::lock_guard<std::mutex> lock(worker.mutex);
+		worker.jobs.push_back(std::move(job));
+	}
+
+	//Count the job under the sleep lock so no worker misses the wake up
+	{
+		std::lock_guard<std::mutex> lock(mSleepMutex);
+		mQueuedJobs += 1;
+	}
+	mJobQueued.notify_one();
+}
+
+void ThreadPool::wait()
+{
+	std::unique_lock<std::mutex> lock(mSleepMutex);
+	mJobsDone.wait(lock, [this] { return mUnfinishedJobs == 0; });
+}
+
+int ThreadPool::getThreadCount()
+{
+	return (int)mThreads.size();
+}
+
+bool ThreadPool::takeJob(int index, std::function<void()>& job)
+{
+	//Own queue first, newest job is the one most likely still in cache
+	{
+		Worker& own = *mWorkers[index];
+		std::lock_guard<std::mutex> lock(own.mutex);
+		if (!own.jobs.empty())
+		{
+			job = std::move(own.jobs.back());
+			own.jobs.pop_back();
+			return true;
+		}
+	}
+
+	//Steal from the front of the other queues
+	int totalWorkers = (int)mWorkers.size();
+	for (int offset = 1; offset < totalWorkers; ++offset)
+	{
+		Worker& victim = *mWorkers[(index + offset) % totalWorkers];
+		std::lock_guard<std::mutex> lock(victim.mutex);
+		if (!victim.jobs.empty())
+		{
+			job = std::move(victim.jobs.front());
+			victim.jobs.pop_front();
+			return true;
+		}
+	}
+	return false;
+}
+
+void ThreadPool::workerLoop(int index)
+{
+	std::function<void()> job;
+	while (true)
+	{
+		if (takeJob(index, job))
+		{
+			mQueuedJobs -= 1;
+			job();
+			job = nullptr;
+
+			//Last job done, wake up whoever waits for the batch
+			if (--mUnfinishedJobs == 0)
+			{
+				std::lock_guard<std::mutex> lock(mSleepMutex);
+				mJobsDone.notify_all();
+			}
+			continue;
+		}
+
+		//Nothing to run or steal, sleep until a job shows up
+		std::unique_lock<std::mutex> lock(mSleepMutex);
+		mJobQueued.wait(lock, [this] { return mStopping || mQueuedJobs > 0; });
+		if (mStopping && mQueuedJobs == 0)
+		{
+			return;
+		}
+	}
+}
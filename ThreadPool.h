@@ -0,0 +1,59 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+//Fixed set of worker threads, each with its own job queue
+//Idle workers steal the oldest jobs of busy ones
+class ThreadPool
+{
+public:
+	//Starts the workers, 0 uses one per hardware thread
+	explicit ThreadPool(int totalThreads = 0);
+
+	//Finishes queued jobs and joins the workers
+	~ThreadPool();
+
+	//Queues a job, jobs are handed to the workers in turn
+	void submit(std::function<void()> job);
+
+	//Blocks until every submitted job has finished
+	void wait();
+
+	//Gets number of workers
+	int getThreadCount();
+
+private:
+	struct Worker
+	{
+		std::mutex mutex;
+		std::deque<std::function<void()>> jobs;
+	};
+
+	//Runs jobs until the pool stops
+	void workerLoop(int index);
+
+	//Takes the newest job of a worker, or steals the oldest job of another one
+	bool takeJob(int index, std::function<void()>& job);
+
+	std::vector<std::unique_ptr<Worker>> mWorkers;
+	std::vector<std::thread> mThreads;
+
+	//Idle workers sleep until jobs are queued
+	std::mutex mSleepMutex;
+	std::condition_variable mJobQueued;
+	std::condition_variable mJobsDone;
+
+	//Jobs waiting in queues and jobs not finished yet
+	std::atomic<int> mQueuedJobs;
+	std::atomic<int> mUnfinishedJobs;
+	std::atomic<bool> mStopping;
+
+	//Worker that gets the next submitted job
+	unsigned int mNextWorker;
+};
@@ -0,0 +1,162 @@
+#include "TraceRecorder.h"
+#include <stdio.h>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+struct TraceEvent
+{
+	const char* name;
+	long long timeNs;
+
+	//'B' for begin, 'E' for end
+	char phase;
+};
+
+struct TraceThreadBuffer
+{
+	int threadId;
+	std::atomic<const char*> threadName;
+
+	//Events ever written, the writer publishes an event by bumping it
+	std::atomic<unsigned> head;
+	TraceEvent events[TraceRecorder::EVENTS_PER_THREAD];
+};
+
+//Every thread that ever recorded, buffers outlive their threads so the trace keeps them
+static std::mutex gBuffersMutex;
+static std::vector<std::unique_ptr<TraceThreadBuffer>> gBuffers;
+
+//Trace time starts at program start
+static const std::chrono::steady_clock::time_point gTraceStart = std::chrono::steady_clock::now();
+
+//Gets the calling thread's buffer, registering it on first use
+static TraceThreadBuffer& getThreadBuffer()
+{
+	thread_local TraceThreadBuffer* buffer = NULL;
+	if (buffer == NULL)
+	{
+		std::lock_guard<std::mutex> lock(gBuffersMutex);
+		gBuffers.push_back(std::unique_ptr<TraceThreadBuffer>(new TraceThreadBuffer()));
+		buffer = gBuffers.back().get();
+		buffer->threadId = (int)gBuffers.size();
+		buffer->threadName = NULL;
+		buffer->head = 0;
+	}
+	return *buffer;
+}
+
+//Appends an event to the calling thread's ring buffer
+static void record(const char* name, char phase)
+{
+	TraceThreadBuffer& buffer = getThreadBuffer();
+	unsigned head = buffer.head.load(std::memory_order_relaxed);
+
+	TraceEvent& event = buffer.events[head % TraceRecorder::EVENTS_PER_THREAD];
+	event.name = name;
+	event.timeNs = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - gTraceStart).count();
+	event.phase = phase;
+
+	buffer.head.store(head + 1, std::memory_order_release);
+}
+
+void TraceRecorder::begin(const char* name)
+{
+	record(name, 'B');
+}
+
+void TraceRecorder::end()
+{
+	record(NULL, 'E');
+}
+
+void TraceRecorder::setThreadName(const char* name)
+{
+	getThreadBuffer().threadName = name;
+}
+
+bool TraceRecorder::writeChromeTrace(const char* path)
+{
+	FILE* file = fopen(path, "w");
+	if (file == NULL)
+	{
+		printf("Unable to open trace file %s!\n", path);
+		return false;
+	}
+
+	fprintf(file, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+	bool isFirst = true;
+
+	std::lock_guard<std::mutex> lock(gBuffersMutex);
+	std::vector<TraceEvent> events;
+	for (size_t i = 0; i < gBuffers.size(); ++i)
+	{
+		TraceThreadBuffer& buffer = *gBuffers[i];
+
+		//Copy what's published, then drop whatever the writer lapped while copying
+		//Reading the plain events while their thread keeps recording is a deliberate race, copies of overwritten slots are thrown away below
+		unsigned head = buffer.head.load(std::memory_order_acquire);
+		unsigned first = head > (unsigned)EVENTS_PER_THREAD ? head - EVENTS_PER_THREAD : 0;
+		events.clear();
+		for (unsigned index = first; index < head; ++index)
+		{
+			events.push_back(buffer.events[index % EVENTS_PER_THREAD]);
+		}
+		//The writer may be part way through the event at headAfterCopy, whose slot is that of the event a ring before it
+		unsigned headAfterCopy = buffer.head.load(std::memory_order_acquire);
+		unsigned touched = headAfterCopy - first + 1;
+		size_t lapped = touched > (unsigned)EVENTS_PER_THREAD ? touched - EVENTS_PER_THREAD : 0;
+		if (lapped > events.size())
+		{
+			lapped = events.size();
+		}
+
+		const char* threadName = buffer.threadName;
+		if (threadName != NULL)
+		{
+			fprintf(file, "%s{\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"name\":\"thread_name\",\"args\":{\"name\":\"%s\"}}",
+				isFirst ? "" : ",\n", buffer.threadId, threadName);
+			isFirst = false;
+		}
+
+		//Ends whose begin was overwritten would confuse the viewer
+		int depth = 0;
+		for (size_t e = lapped; e < events.size(); ++e)
+		{
+			const TraceEvent& event = events[e];
+			if (event.phase == 'E')
+			{
+				if (depth == 0)
+				{
+					continue;
+				}
+				depth -= 1;
+				fprintf(file, "%s{\"ph\":\"E\",\"pid\":1,\"tid\":%d,\"ts\":%.3f}",
+					isFirst ? "" : ",\n", buffer.threadId, event.timeNs / 1000.0);
+			}
+			else
+			{
+				depth += 1;
+				fprintf(file, "%s{\"ph\":\"B\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,\"name\":\"%s\"}",
+					isFirst ? "" : ",\n", buffer.threadId, event.timeNs / 1000.0, event.name);
+			}
+			isFirst = false;
+		}
+	}
+
+	fprintf(file, "\n]}\n");
+	fclose(file);
+	return true;
+}
+
+TraceScope::TraceScope(const char* name)
+{
+	TraceRecorder::begin(name);
+}
+
+TraceScope::~TraceScope()
+{
+	TraceRecorder::end();
+}
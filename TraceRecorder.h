@@ -0,0 +1,29 @@
+#pragma once
+
+//Zone begin and end events of every thread, written out on demand as a Chrome trace for Perfetto or chrome://tracing
+//Each thread records into its own ring buffer without locking, only the first event of a thread takes a lock
+//Zone and thread names are kept as pointers, pass string literals
+class TraceRecorder
+{
+public:
+	//Events kept per thread, older ones are overwritten
+	static const int EVENTS_PER_THREAD = 1 << 16;
+
+	//Records the start and end of a zone on the calling thread
+	static void begin(const char* name);
+	static void end();
+
+	//Names the calling thread in the trace
+	static void setThreadName(const char* name);
+
+	//Writes the events of all threads as Chrome trace JSON, safe to call while other threads record
+	static bool writeChromeTrace(const char* path);
+};
+
+//Records a zone until the end of the enclosing scope
+class TraceScope
+{
+public:
+	explicit TraceScope(const char* name);
+	~TraceScope();
+};